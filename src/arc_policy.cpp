@@ -0,0 +1,123 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "arc_policy.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+ArcPolicy::ArcPolicy(std::uint32_t numFrames)
+    : ReplacementPolicy(numFrames),
+      p(0),
+      lists(numFrames, NUM_LISTS),
+      frames(numFrames, FrameState{0, FREE}) {
+  for (FrameId frame = 0; frame < numFrames; frame++)
+    lists.pushBack(FREE, frame);
+}
+
+void ArcPolicy::trimGhosts() {
+  while (b1.size() > 0 && lists.size(T1) + b1.size() > numFrames) b1.popFront();
+  while (b2.size() > 0 &&
+         lists.size(T1) + lists.size(T2) + b1.size() + b2.size() >
+             2 * numFrames)
+    b2.popFront();
+}
+
+void ArcPolicy::commitEviction(FrameId frame) {
+  FrameState &state = frames[frame];
+  if (lists.listOf(frame) != FrameLists::NO_LIST || state.pageKey == 0) return;
+  if (state.list == T1)
+    b1.pushBack(state.pageKey);
+  else if (state.list == T2)
+    b2.pushBack(state.pageKey);
+  state.pageKey = 0;
+  trimGhosts();
+}
+
+void ArcPolicy::onAccess(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  const int list = lists.listOf(frame);
+  if (list != T1 && list != T2) return;
+  lists.remove(frame);
+  frames[frame].list = T2;
+  lists.pushBack(T2, frame);
+}
+
+void ArcPolicy::onLoad(FrameId frame, std::uint64_t pageKey) {
+  std::lock_guard<std::mutex> guard(latch);
+  commitEviction(frame);
+  lists.remove(frame);
+
+  FrameState &state = frames[frame];
+  state.pageKey = pageKey;
+  if (b1.contains(pageKey)) {
+    // Recently evicted after one use: T1 was too small.
+    const std::uint32_t delta = std::max<std::uint32_t>(
+        1, b2.size() / std::max<std::size_t>(1, b1.size()));
+    p = std::min(numFrames, p + delta);
+    b1.remove(pageKey);
+    state.list = T2;
+  } else if (b2.contains(pageKey)) {
+    // Recently evicted after repeated use: T2 was too small.
+    const std::uint32_t delta = std::max<std::uint32_t>(
+        1, b1.size() / std::max<std::size_t>(1, b2.size()));
+    p = p > delta ? p - delta : 0;
+    b2.remove(pageKey);
+    state.list = T2;
+  } else {
+    state.list = T1;
+  }
+  lists.pushBack(state.list, frame);
+  trimGhosts();
+}
+
+void ArcPolicy::frameFreed(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  commitEviction(frame);
+  lists.remove(frame);
+  frames[frame].pageKey = 0;
+  frames[frame].list = FREE;
+  lists.pushBack(FREE, frame);
+}
+
+void ArcPolicy::frameRestored(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  if (lists.listOf(frame) != FrameLists::NO_LIST) return;
+  lists.pushBack(frames[frame].list, frame);
+}
+
+void ArcPolicy::peekVictims(std::vector<FrameId> &frames,
+                            std::uint32_t count) {
+  std::lock_guard<std::mutex> guard(latch);
+  const int first =
+      lists.size(T1) > 0 && (lists.size(T1) > p || lists.size(T2) == 0) ? T1
+                                                                         : T2;
+  peekList(lists, first, frames, count);
+  peekList(lists, first == T1 ? T2 : T1, frames, count);
+}
+
+bool ArcPolicy::chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                             std::uint64_t &examined) {
+  std::lock_guard<std::mutex> guard(latch);
+  const int first =
+      lists.size(T1) > 0 && (lists.size(T1) > p || lists.size(T2) == 0) ? T1
+                                                                         : T2;
+  const int second = first == T1 ? T2 : T1;
+  FrameId victim = claimFromList(lists, FREE, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME)
+    victim = claimFromList(lists, first, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME)
+    victim = claimFromList(lists, second, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME) return false;
+
+  frame = victim;
+  return true;
+}
+
+}  // namespace badgerdb
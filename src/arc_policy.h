@@ -0,0 +1,96 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Adaptive Replacement Cache.
+ *
+ * T1 holds pages seen once recently and T2 pages seen at least twice; the
+ * ghost lists B1 and B2 remember pages recently evicted from each.  A miss
+ * that hits B1 grows the target size p of T1, one that hits B2 shrinks it, and
+ * victims come from T1 while it is larger than p.
+ *
+ * Victims are chosen before BufMgr knows which page will take the frame, so
+ * the tie-break of the original REPLACE on a B2 hit is not applied.
+ */
+class ArcPolicy : public ReplacementPolicy {
+ public:
+  explicit ArcPolicy(std::uint32_t numFrames);
+
+  const char *name() const override { return "arc"; }
+
+  void frameFreed(FrameId frame) override;
+
+  void frameRestored(FrameId frame) override;
+
+  void peekVictims(std::vector<FrameId> &frames, std::uint32_t count) override;
+
+ protected:
+  void onAccess(FrameId frame) override;
+
+  void onLoad(FrameId frame, std::uint64_t pageKey) override;
+
+  bool chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                    std::uint64_t &examined) override;
+
+ private:
+  enum { FREE, T1, T2, NUM_LISTS };
+
+  /**
+   * @brief Bookkeeping for one frame.
+   */
+  struct FrameState {
+    /**
+     * Key of the page in the frame (also while it is a victim), or 0.
+     */
+    std::uint64_t pageKey;
+
+    /**
+     * List the frame is on, or was taken from while it is a victim.
+     */
+    int list;
+  };
+
+  /**
+   * If frame was handed out as a victim, remembers its page in B1 or B2.
+   */
+  void commitEviction(FrameId frame);
+
+  /**
+   * Trims the ghost lists so that |T1| + |B1| <= c and the directory holds
+   * at most 2c pages.
+   */
+  void trimGhosts();
+
+  /**
+   * Latch guarding everything below.
+   */
+  std::mutex latch;
+
+  /**
+   * Target size of T1.
+   */
+  std::uint32_t p;
+
+  FrameLists lists;
+
+  std::vector<FrameState> frames;
+
+  GhostList b1;
+  GhostList b2;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,86 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <string>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const int kDeletes = 1000;
+const std::uint32_t kPoolFrames = 256;
+
+/**
+ * Appends pages to an empty file, then deletes every other one of the first
+ * kDeletes * 2 and allocates them again.
+ */
+void runFile(PageId pages) {
+  const std::string filename = "bench.alloc";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    Timer timer;
+    for (PageId i = 0; i < pages; ++i) file.allocatePage();
+    report("allocatePage() appends pages=" + std::to_string(pages), pages,
+           timer.seconds());
+
+    timer = Timer();
+    for (PageId pageNo = 1; pageNo <= 2 * kDeletes; pageNo += 2) {
+      file.deletePage(pageNo);
+    }
+    for (int i = 0; i < kDeletes; ++i) file.allocatePage();
+    report("deletePage() + allocatePage() pages=" + std::to_string(pages),
+           kDeletes, timer.seconds());
+  }
+  File::remove(filename);
+}
+
+/**
+ * Loads pages in one allocatePages() call, and through BufMgr::allocPage().
+ */
+void runBulk(PageId pages) {
+  const std::string filename = "bench.alloc";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    Timer timer;
+    file.allocatePages(pages);
+    report("allocatePages() pages=" + std::to_string(pages), pages,
+           timer.seconds());
+  }
+  File::remove(filename);
+  {
+    File file = File::create(filename);
+    BufMgr bufMgr(kPoolFrames);
+    Timer timer;
+    for (PageId i = 0; i < pages; ++i) {
+      PageId pageNo;
+      Page *page;
+      bufMgr.allocPage(file, pageNo, page);
+      bufMgr.unPinPage(file, pageNo, true);
+    }
+    bufMgr.flushFile(file);
+    report("BufMgr::allocPage() + flushFile() pages=" + std::to_string(pages),
+           pages, timer.seconds());
+  }
+  File::remove(filename);
+}
+
+}  // namespace
+
+void allocBench() {
+  for (PageId pages = 2500; pages <= 20000; pages *= 2) runFile(pages);
+  runBulk(20000);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
@@ -0,0 +1,150 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "exceptions/file_not_found_exception.h"
+#include "file.h"
+
+namespace badgerdb {
+namespace bench {
+
+/**
+ * @brief Wall-clock stopwatch used by the benchmarks.
+ */
+class Timer {
+ public:
+  Timer() : start_(std::chrono::steady_clock::now()) {}
+
+  /**
+   * Returns the seconds elapsed since construction.
+   */
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Removes the given file if it exists (left over from a crashed run).
+ *
+ * @param filename  Name of the file.
+ */
+inline void removeIfExists(const std::string &filename) {
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException &) {
+  }
+}
+
+/**
+ * Prints one result line in a format shared by all benchmarks.
+ *
+ * @param name    Name of the measured configuration.
+ * @param ops     Number of operations performed.
+ * @param seconds Time the operations took.
+ */
+inline void report(const std::string &name, double ops, double seconds) {
+  std::printf("%-40s %12.0f ops %10.3f s %14.0f ops/s\n", name.c_str(), ops,
+              seconds, ops / seconds);
+}
+
+/**
+ * Multithreaded buffer pool hit/miss benchmark.
+ */
+void bufferBench();
+
+/**
+ * Buffer pool hash table microbenchmark, against the former chained table.
+ */
+void hashTableBench();
+
+/**
+ * Hit ratio and eviction cost of each replacement policy on a mixed
+ * lookup/scan workload.
+ */
+void policyBench();
+
+/**
+ * Point-lookup hit ratio and scan throughput with and without a
+ * BufAccessStrategy ring for the scan.
+ */
+void scanBench();
+
+/**
+ * Cold sequential scan throughput with and without read-ahead.
+ */
+void readAheadBench();
+
+/**
+ * Foreground write-backs on an update workload with and without the
+ * background writer.
+ */
+void bgWriterBench();
+
+/**
+ * flushFile() against writing the dirty pages one at a time.
+ */
+void flushBench();
+
+/**
+ * Page reads and writes through the fstream and pread/pwrite File backends.
+ */
+void fileIOBench();
+
+/**
+ * Random read throughput and page cache footprint with and without O_DIRECT.
+ */
+void directBench();
+
+/**
+ * Random direct reads one at a time against batches on the io_uring engine,
+ * by queue depth, and prefetched through the buffer pool.
+ */
+void ioEngineBench();
+
+/**
+ * Random point lookups by copying pages, through the buffer pool, and through
+ * in-place views, with the pread and mmap backends.
+ */
+void mmapBench();
+
+/**
+ * Bulk page allocation, and deletion and reuse of pages, by file size.
+ */
+void allocBench();
+
+/**
+ * Commits (a page write and File::sync()) by concurrent threads under each
+ * SyncPolicy, and how many device syncs they shared.
+ */
+void syncBench();
+
+/**
+ * Sequential scans by single-page reads, into new or reused Pages, and by
+ * vectored File::readPages() runs, and sorted batches of clustered lookups read either way.
+ */
+void readPagesBench();
+
+/**
+ * Record scans and point lookups through the buffer pool, copying records or
+ * viewing them in place, with the heap allocations each makes; and mass
+ * deletes of records.
+ */
+void recordBench();
+
+}  // namespace bench
+}  // namespace badgerdb
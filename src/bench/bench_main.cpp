@@ -0,0 +1,58 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include "bench/bench.h"
+
+using namespace badgerdb::bench;
+
+namespace {
+
+struct Benchmark {
+  const char *name;
+  void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    {"buffer", bufferBench},
+    {"hash_table", hashTableBench},
+    {"policy", policyBench},
+    {"scan", scanBench},
+    {"readahead", readAheadBench},
+    {"bgwriter", bgWriterBench},
+    {"flush", flushBench},
+    {"file_io", fileIOBench},
+    {"direct", directBench},
+    {"io_engine", ioEngineBench},
+    {"mmap", mmapBench},
+    {"alloc", allocBench},
+    {"sync", syncBench},
+    {"read_pages", readPagesBench},
+    {"record", recordBench},
+};
+
+}  // namespace
+
+/**
+ * Runs the benchmarks named on the command line, or all of them if none are
+ * given.
+ */
+int main(int argc, char **argv) {
+  for (const Benchmark &benchmark : benchmarks) {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], benchmark.name) == 0) selected = true;
+    }
+    if (!selected) continue;
+    std::cout << "== " << benchmark.name << " ==\n";
+    benchmark.run();
+  }
+  return 0;
+}
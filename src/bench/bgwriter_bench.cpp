@@ -0,0 +1,71 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const std::uint32_t kPoolFrames = 256;
+const int kOps = 40000;
+const int kDirtyPercent = 30;
+
+/**
+ * Random reads over a file eight times the pool, dirtying some of the pages,
+ * so that most misses evict a dirty page.
+ */
+void runUpdates(File &file, bool backgroundWriter) {
+  BufMgr bufMgr(kPoolFrames);
+  bufMgr.setMaxReadAhead(0);
+  if (backgroundWriter) bufMgr.startBackgroundWriter();
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+  std::uniform_int_distribution<int> percent(0, 99);
+  Page *page;
+
+  Timer timer;
+  for (int i = 0; i < kOps; ++i) {
+    const PageId pageNo = pick(rng);
+    bufMgr.readPage(file, pageNo, page);
+    bufMgr.unPinPage(file, pageNo, percent(rng) < kDirtyPercent);
+  }
+  const double seconds = timer.seconds();
+  bufMgr.stopBackgroundWriter();
+
+  const BufStats stats = bufMgr.getBufStats();
+  report(backgroundWriter ? "background writer" : "no background writer", kOps,
+         seconds);
+  std::printf("  misses %d  foreground writes %d  background writes %d\n",
+              stats.diskreads, stats.evictwrites, stats.bgwrites);
+}
+
+}  // namespace
+
+void bgWriterBench() {
+  const std::string filename = "bench.bgwriter";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 1; i < kFilePages; ++i) file.allocatePage();
+
+    runUpdates(file, false);
+    runUpdates(file, true);
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
@@ -0,0 +1,97 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const int kHitOpsPerThread = 200000;
+const int kMissOpsPerThread = 20000;
+
+/**
+ * Has each of <threads> threads pin and unpin <ops> random pages among the
+ * first <working_set> pages of the file, through PinnedPage handles if
+ * <pinned>.
+ */
+void runReaders(BufMgr &bufMgr, File &file, int threads,
+                std::uint32_t working_set, int ops, bool pinned = false) {
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&bufMgr, &file, t, working_set, ops, pinned]() {
+      std::minstd_rand rng(t + 1);
+      std::uniform_int_distribution<PageId> pick(1, working_set);
+      Page *page;
+      for (int i = 0; i < ops; ++i) {
+        const PageId pageNo = pick(rng);
+        if (pinned) {
+          PinnedPage pinnedPage = bufMgr.readPage(file, pageNo);
+        } else {
+          bufMgr.readPage(file, pageNo, page);
+          bufMgr.unPinPage(file, pageNo, false);
+        }
+      }
+    });
+  }
+  for (std::thread &worker : workers) worker.join();
+}
+
+}  // namespace
+
+void bufferBench() {
+  const std::string filename = "bench.buffer";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 0; i < kFilePages; ++i) file.allocatePage();
+
+    const std::uint32_t hw = std::thread::hardware_concurrency();
+    std::cout << "hardware threads: " << hw << "\n";
+    for (int threads = 1; threads <= 32; threads *= 2) {
+      // Hits: the working set fits in the pool.
+      {
+        BufMgr bufMgr(kFilePages);
+        runReaders(bufMgr, file, 1, kFilePages, kHitOpsPerThread);  // warm up
+        Timer timer;
+        runReaders(bufMgr, file, threads, kFilePages, kHitOpsPerThread);
+        report("hit  threads=" + std::to_string(threads),
+               double(threads) * kHitOpsPerThread, timer.seconds());
+      }
+      // Hits through PinnedPage: no second hash lookup to unpin.
+      {
+        BufMgr bufMgr(kFilePages);
+        runReaders(bufMgr, file, 1, kFilePages, kHitOpsPerThread);  // warm up
+        Timer timer;
+        runReaders(bufMgr, file, threads, kFilePages, kHitOpsPerThread, true);
+        report("hit  pinned threads=" + std::to_string(threads),
+               double(threads) * kHitOpsPerThread, timer.seconds());
+      }
+      // Misses: the working set is four times the pool.
+      {
+        BufMgr bufMgr(kFilePages / 4);
+        Timer timer;
+        runReaders(bufMgr, file, threads, kFilePages, kMissOpsPerThread);
+        report("miss threads=" + std::to_string(threads),
+               double(threads) * kMissOpsPerThread, timer.seconds());
+      }
+    }
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
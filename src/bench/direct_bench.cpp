@@ -0,0 +1,106 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const std::uint32_t kPoolFrames = 256;
+const int kReads = 20000;
+
+/**
+ * Drops the file's pages from the operating system's page cache.
+ */
+void dropCache(const std::string &filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  ::fdatasync(fd);
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  ::close(fd);
+}
+
+/**
+ * Returns the number of bytes of the file held in the operating system's page
+ * cache.
+ */
+std::size_t cachedBytes(const std::string &filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) return 0;
+  const off_t size = ::lseek(fd, 0, SEEK_END);
+  void *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) return 0;
+  const long osPage = ::sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> resident((size + osPage - 1) / osPage);
+  std::size_t bytes = 0;
+  if (::mincore(map, size, resident.data()) == 0) {
+    for (unsigned char r : resident) bytes += (r & 1) ? osPage : 0;
+  }
+  ::munmap(map, size);
+  return bytes;
+}
+
+/**
+ * Reads random pages through a pool an eighth of the file's size, then
+ * reports the throughput and how much of the file the operating system cached
+ * on top of the pool.
+ */
+void runBackend(const std::string &filename, FileBackend backend,
+                const std::string &name) {
+  dropCache(filename);
+  {
+    File file = File::open(filename, backend);
+    BufMgr bufMgr(kPoolFrames);
+    bufMgr.setMaxReadAhead(0);
+    std::minstd_rand rng(1);
+    std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+    Page *page;
+
+    Timer timer;
+    for (int i = 0; i < kReads; ++i) {
+      const PageId pageNo = pick(rng);
+      bufMgr.readPage(file, pageNo, page);
+      bufMgr.unPinPage(file, pageNo, false);
+    }
+    report(name + " random reads", kReads, timer.seconds());
+  }
+  std::printf("%-40s %8zu KiB pool %8zu KiB OS cache\n",
+              (name + " memory").c_str(),
+              std::size_t(kPoolFrames) * Page::SIZE / 1024,
+              cachedBytes(filename) / 1024);
+}
+
+}  // namespace
+
+void directBench() {
+  const std::string filename = "bench.direct";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 1; i < kFilePages; ++i) file.allocatePage();
+  }
+  runBackend(filename, FileBackend::POSIX, "pread/pwrite");
+  runBackend(filename, FileBackend::DIRECT, "O_DIRECT");
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
@@ -0,0 +1,76 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 1024;
+const int kReadsPerThread = 20000;
+const int kWrites = 10000;
+
+/**
+ * Has <threads> threads read random pages of the file.
+ */
+void runReads(File &file, int threads) {
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&file, t]() {
+      std::minstd_rand rng(t + 1);
+      std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+      for (int i = 0; i < kReadsPerThread; ++i) file.readPage(pick(rng));
+    });
+  }
+  for (std::thread &worker : workers) worker.join();
+}
+
+void runBackend(const std::string &filename, FileBackend backend,
+                const std::string &name) {
+  File file = File::open(filename, backend);
+
+  for (int threads = 1; threads <= 4; threads *= 2) {
+    Timer timer;
+    runReads(file, threads);
+    report(name + " random reads threads=" + std::to_string(threads),
+           double(threads) * kReadsPerThread, timer.seconds());
+  }
+
+  std::vector<Page> pages;
+  for (PageId pageNo = 1; pageNo < kFilePages; ++pageNo)
+    pages.push_back(file.readPage(pageNo));
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<std::size_t> pick(0, pages.size() - 1);
+  Timer timer;
+  for (int i = 0; i < kWrites; ++i) file.writePage(pages[pick(rng)]);
+  report(name + " random writes", kWrites, timer.seconds());
+}
+
+}  // namespace
+
+void fileIOBench() {
+  const std::string filename = "bench.file_io";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 1; i < kFilePages; ++i) file.allocatePage();
+  }
+  runBackend(filename, FileBackend::STREAM, "fstream");
+  runBackend(filename, FileBackend::POSIX, "pread/pwrite");
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
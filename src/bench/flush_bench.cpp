@@ -0,0 +1,85 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 1024;
+const int kRounds = 10;
+
+/**
+ * Dirties percent of the pages of the file, touched in random order so that
+ * frame order and page order differ, and times writing them back either with
+ * flushFile() or one File::writePage() per frame as flushFile() used to.
+ */
+void runFlush(File &file, int percent, bool batched) {
+  BufMgr bufMgr(kFilePages);
+  bufMgr.setMaxReadAhead(0);
+  std::vector<PageId> pageNos;
+  for (PageId pageNo = 1; pageNo < kFilePages; ++pageNo)
+    pageNos.push_back(pageNo);
+  std::minstd_rand rng(1);
+  pageNos.resize(pageNos.size() * percent / 100);
+
+  double seconds = 0;
+  for (int round = 0; round < kRounds; ++round) {
+    std::shuffle(pageNos.begin(), pageNos.end(), rng);
+    std::vector<Page *> pages;
+    for (PageId pageNo : pageNos) {
+      Page *page;
+      bufMgr.readPage(file, pageNo, page);
+      bufMgr.unPinPage(file, pageNo, true);
+      pages.push_back(page);
+    }
+
+    Timer timer;
+    if (batched) {
+      bufMgr.flushFile(file);
+    } else {
+      for (Page *page : pages) file.writePage(*page);
+    }
+    seconds += timer.seconds();
+    if (!batched) bufMgr.flushFile(file);  // untimed: empties the pool
+  }
+
+  report(std::string(batched ? "flushFile" : "per-page writes") + " dirty=" +
+             std::to_string(percent) + "%",
+         double(kRounds) * pageNos.size(), seconds);
+}
+
+}  // namespace
+
+void flushBench() {
+  const std::string filename = "bench.flush";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 1; i < kFilePages; ++i) file.allocatePage();
+
+    const int percents[] = {10, 50, 100};
+    for (int percent : percents) {
+      runFlush(file, percent, false);
+      runFlush(file, percent, true);
+    }
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
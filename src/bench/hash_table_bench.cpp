@@ -0,0 +1,151 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bench/bench.h"
+#include "bufHashTbl.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+/**
+ * @brief The chained hash table BufHashTbl used to be, kept as a baseline: one
+ * shared_ptr node (holding a File copy) allocated per insert, chains walked
+ * comparing filenames.
+ */
+class ChainedHashTbl {
+ public:
+  explicit ChainedHashTbl(int htSize) : HTSIZE(htSize), ht(htSize) {}
+
+  void insert(const File &file, const PageId pageNo, const FrameId frameNo) {
+    const int index = hash(file, pageNo);
+    std::shared_ptr<Bucket> bucket = std::make_shared<Bucket>();
+    bucket->file = file;
+    bucket->pageNo = pageNo;
+    bucket->frameNo = frameNo;
+    bucket->next = ht[index];
+    ht[index] = bucket;
+  }
+
+  bool lookup(const File &file, const PageId pageNo, FrameId &frameNo) {
+    for (std::shared_ptr<Bucket> bucket = ht[hash(file, pageNo)]; bucket;
+         bucket = bucket->next) {
+      if (bucket->file == file && bucket->pageNo == pageNo) {
+        frameNo = bucket->frameNo;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void remove(const File &file, const PageId pageNo) {
+    const int index = hash(file, pageNo);
+    std::shared_ptr<Bucket> bucket = ht[index];
+    std::shared_ptr<Bucket> prev;
+    while (bucket) {
+      if (bucket->file == file && bucket->pageNo == pageNo) {
+        if (prev)
+          prev->next = bucket->next;
+        else
+          ht[index] = bucket->next;
+        return;
+      }
+      prev = bucket;
+      bucket = bucket->next;
+    }
+  }
+
+ private:
+  struct Bucket {
+    File file;
+    PageId pageNo;
+    FrameId frameNo;
+    std::shared_ptr<Bucket> next;
+  };
+
+  int hash(const File &file, const PageId pageNo) const {
+    return (std::hash<std::string>{}(file.filename()) ^
+            std::hash<PageId>{}(pageNo)) %
+           HTSIZE;
+  }
+
+  int HTSIZE;
+  std::vector<std::shared_ptr<Bucket>> ht;
+};
+
+const int kBufs = 100000;
+const int kRounds = 20;
+
+int tableSize(int bufs) { return ((int)(bufs * 1.2) & -2) + 1; }
+
+/**
+ * Times kRounds rounds of inserting kBufs pages, looking each of them up
+ * twice and removing them again.  Partition latches are taken the way BufMgr
+ * takes them.
+ */
+void benchFlat(const File &file) {
+  BufHashTbl table(tableSize(kBufs));
+  FrameId frame;
+  Timer timer;
+  for (int round = 0; round < kRounds; ++round) {
+    for (PageId p = 1; p <= kBufs; ++p) {
+      std::lock_guard<std::mutex> latch(table.partitionLatch(file, p));
+      table.insert(file, p, p);
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+      for (PageId p = 1; p <= kBufs; ++p) {
+        std::lock_guard<std::mutex> latch(table.partitionLatch(file, p));
+        table.lookup(file, p, frame);
+      }
+    }
+    for (PageId p = 1; p <= kBufs; ++p) {
+      std::lock_guard<std::mutex> latch(table.partitionLatch(file, p));
+      table.remove(file, p);
+    }
+  }
+  report("open addressing insert+2 lookups+remove", 4.0 * kRounds * kBufs,
+         timer.seconds());
+}
+
+void benchChained(const File &file) {
+  ChainedHashTbl table(tableSize(kBufs));
+  FrameId frame;
+  Timer timer;
+  for (int round = 0; round < kRounds; ++round) {
+    for (PageId p = 1; p <= kBufs; ++p) table.insert(file, p, p);
+    for (int pass = 0; pass < 2; ++pass) {
+      for (PageId p = 1; p <= kBufs; ++p) table.lookup(file, p, frame);
+    }
+    for (PageId p = 1; p <= kBufs; ++p) table.remove(file, p);
+  }
+  report("chained insert+2 lookups+remove", 4.0 * kRounds * kBufs,
+         timer.seconds());
+}
+
+}  // namespace
+
+void hashTableBench() {
+  const std::string filename = "bench.hash_table.with.a.realistically.long.name";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    benchChained(file);
+    benchFlat(file);
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
@@ -0,0 +1,110 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const std::uint32_t kPoolFrames = 256;
+const int kReads = 4096;
+
+/**
+ * Returns kReads random page numbers of the file.
+ */
+std::vector<PageId> randomPages() {
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+  std::vector<PageId> pageNos(kReads);
+  for (PageId &pageNo : pageNos) pageNo = pick(rng);
+  return pageNos;
+}
+
+/**
+ * Reads the pages through the engine with up to depth reads in flight.
+ */
+void runEngine(File &file, IOEngine &engine, std::uint32_t depth,
+               const std::string &name) {
+  const std::vector<PageId> pageNos = randomPages();
+  std::vector<Page> pages(depth);
+  Timer timer;
+  for (std::size_t start = 0; start < pageNos.size(); start += depth) {
+    for (std::uint32_t i = 0; i < depth && start + i < pageNos.size(); ++i) {
+      file.readPageAsync(engine, pageNos[start + i], pages[i], [](int) {});
+    }
+    engine.wait();
+  }
+  report(name + " depth=" + std::to_string(depth), kReads, timer.seconds());
+}
+
+/**
+ * Reads the pages through a pool that mostly misses, one at a time or after
+ * prefetching them in batches.
+ */
+void runBufMgr(File &file, std::uint32_t batch, const std::string &name) {
+  const std::vector<PageId> pageNos = randomPages();
+  BufMgr bufMgr(kPoolFrames);
+  bufMgr.setMaxReadAhead(0);
+  Page *page;
+  Timer timer;
+  for (std::size_t start = 0; start < pageNos.size(); start += batch) {
+    const std::uint32_t count = static_cast<std::uint32_t>(
+        std::min<std::size_t>(batch, pageNos.size() - start));
+    if (batch > 1) bufMgr.prefetchPages(file, &pageNos[start], count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+      bufMgr.readPage(file, pageNos[start + i], page);
+      bufMgr.unPinPage(file, pageNos[start + i], false);
+    }
+  }
+  report(name, kReads, timer.seconds());
+}
+
+}  // namespace
+
+void ioEngineBench() {
+  const std::string filename = "bench.io_engine";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 1; i < kFilePages; ++i) file.allocatePage();
+  }
+
+  {
+    // Direct I/O, so that the reads reach the device.
+    File file = File::open(filename, FileBackend::DIRECT);
+    {
+      Timer timer;
+      for (PageId pageNo : randomPages()) file.readPage(pageNo);
+      report("File::readPage() random reads", kReads, timer.seconds());
+    }
+    std::unique_ptr<IOEngine> sync = IOEngine::create(IOEngineType::SYNC);
+    runEngine(file, *sync, 32, "sync engine");
+    std::unique_ptr<IOEngine> uring = IOEngine::create();
+    const std::string name = uring->type() == IOEngineType::IO_URING
+                                 ? "io_uring"
+                                 : "io_uring (unavailable, sync)";
+    for (std::uint32_t depth = 1; depth <= IOEngine::DEFAULT_DEPTH;
+         depth *= 4) {
+      runEngine(file, *uring, depth, name);
+    }
+    runBufMgr(file, 1, "BufMgr misses");
+    runBufMgr(file, 32, "BufMgr misses prefetched by 32");
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
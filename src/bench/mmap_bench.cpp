@@ -0,0 +1,110 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <random>
+#include <string>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const std::uint32_t kPoolFrames = 256;
+const int kLookups = 100000;
+
+/**
+ * Reads the first record of random pages as copied Pages.
+ */
+void runReadPage(File &file, const std::string &name) {
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+  std::size_t bytes = 0;
+  Timer timer;
+  for (int i = 0; i < kLookups; ++i) {
+    const PageId pageNo = pick(rng);
+    bytes += file.readPage(pageNo).viewRecord({pageNo, 1}).size();
+  }
+  report(name, kLookups, timer.seconds());
+  if (bytes == 0) std::printf("no records read\n");
+}
+
+/**
+ * Reads the first record of random pages through a pool that holds an eighth
+ * of the file.
+ */
+void runBufMgr(File &file, const std::string &name) {
+  BufMgr bufMgr(kPoolFrames);
+  bufMgr.setMaxReadAhead(0);
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+  std::size_t bytes = 0;
+  Page *page;
+  Timer timer;
+  for (int i = 0; i < kLookups; ++i) {
+    const PageId pageNo = pick(rng);
+    bufMgr.readPage(file, pageNo, page);
+    bytes += page->viewRecord({pageNo, 1}).size();
+    bufMgr.unPinPage(file, pageNo, false);
+  }
+  report(name, kLookups, timer.seconds());
+  if (bytes == 0) std::printf("no records read\n");
+}
+
+/**
+ * Reads the first record of random pages through views.
+ */
+void runViews(File &file, const std::string &name) {
+  file.adviseAccess(AccessPattern::RANDOM);
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+  std::size_t bytes = 0;
+  Timer timer;
+  for (int i = 0; i < kLookups; ++i) {
+    const PageId pageNo = pick(rng);
+    bytes += file.viewPage(pageNo).viewRecord({pageNo, 1}).size();
+  }
+  report(name, kLookups, timer.seconds());
+  file.adviseAccess(AccessPattern::NORMAL);
+  if (bytes == 0) std::printf("no records read\n");
+}
+
+}  // namespace
+
+void mmapBench() {
+  const std::string filename = "bench.mmap";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    const std::string record(100, 'r');
+    for (std::uint32_t i = 1; i < kFilePages; ++i) {
+      Page page = file.allocatePage();
+      while (page.hasSpaceForRecord(record)) page.insertRecord(record);
+      file.writePage(page);
+    }
+  }
+  {
+    File file = File::open(filename, FileBackend::POSIX);
+    runReadPage(file, "pread readPage() lookups");
+    runBufMgr(file, "pread BufMgr lookups");
+    runViews(file, "pread viewPage() lookups");
+  }
+  {
+    File file = File::open(filename, FileBackend::MMAP);
+    runReadPage(file, "mmap readPage() lookups");
+    runBufMgr(file, "mmap BufMgr lookups");
+    runViews(file, "mmap viewPage() lookups");
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
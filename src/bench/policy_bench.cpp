@@ -0,0 +1,93 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const std::uint32_t kPoolFrames = 256;
+const std::uint32_t kHotPages = 192;
+const std::uint32_t kScanPages = 768;
+const int kOpsPerThread = 20000;
+const int kThreads = 2;
+
+/**
+ * OLTP-style lookups on a small hot set, interrupted by a long sequential
+ * scan every few thousand operations: the workload scan-resistant policies
+ * are designed for.
+ */
+void runMixed(BufMgr &bufMgr, File &file, int seed) {
+  std::minstd_rand rng(seed);
+  std::uniform_int_distribution<PageId> hot(1, kHotPages);
+  std::uniform_int_distribution<PageId> cold(kHotPages + 1, kFilePages);
+  std::uniform_int_distribution<int> percent(0, 99);
+  Page *page;
+  for (int i = 0; i < kOpsPerThread; ++i) {
+    if (i % 5000 == 4999) {
+      const PageId start = cold(rng) % (kFilePages - kScanPages) + 1;
+      for (PageId pageNo = start; pageNo < start + kScanPages; ++pageNo) {
+        bufMgr.readPage(file, pageNo, page);
+        bufMgr.unPinPage(file, pageNo, false);
+      }
+      continue;
+    }
+    const PageId pageNo = percent(rng) < 90 ? hot(rng) : cold(rng);
+    bufMgr.readPage(file, pageNo, page);
+    bufMgr.unPinPage(file, pageNo, false);
+  }
+}
+
+}  // namespace
+
+void policyBench() {
+  const std::string filename = "bench.policy";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 0; i < kFilePages; ++i) file.allocatePage();
+
+    const ReplacementPolicyType types[] = {
+        ReplacementPolicyType::CLOCK, ReplacementPolicyType::LRU_K,
+        ReplacementPolicyType::TWO_Q, ReplacementPolicyType::ARC};
+    for (ReplacementPolicyType type : types) {
+      BufMgr bufMgr(kPoolFrames, type);
+      Timer timer;
+      std::vector<std::thread> workers;
+      for (int t = 0; t < kThreads; ++t) {
+        workers.emplace_back([&bufMgr, &file, t]() {
+          runMixed(bufMgr, file, t + 1);
+        });
+      }
+      for (std::thread &worker : workers) worker.join();
+      const double seconds = timer.seconds();
+
+      const ReplacementStats stats = bufMgr.getReplacementStats();
+      report(bufMgr.getReplacementPolicyName(),
+             double(stats.hits + stats.misses), seconds);
+      std::printf(
+          "  hit ratio %6.3f  examined/eviction %6.2f  ns/eviction %8.0f\n",
+          stats.hitRatio(), stats.examinedPerEviction(),
+          stats.nanosPerEviction());
+    }
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
@@ -0,0 +1,135 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench/bench.h"
+#include "file.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 4096;
+const int kPasses = 8;
+const std::uint32_t kBatchPages = 64;
+const int kBatches = 2000;
+
+/**
+ * Reads the whole file kPasses times, one readPage() per page.
+ */
+void runReadPage(File &file) {
+  std::size_t used = 0;
+  Timer timer;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    for (PageId pageNo = 1; pageNo < kFilePages; ++pageNo) {
+      used += file.readPage(pageNo).page_number() == pageNo;
+    }
+  }
+  report("readPage() scan", double(kPasses) * (kFilePages - 1),
+         timer.seconds());
+  if (used == 0) std::printf("no pages read\n");
+}
+
+/**
+ * Reads the whole file kPasses times, one readPageInto() per page, into the
+ * same Page.
+ */
+void runReadPageInto(File &file) {
+  Page page;
+  std::size_t used = 0;
+  Timer timer;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    for (PageId pageNo = 1; pageNo < kFilePages; ++pageNo) {
+      file.readPageInto(pageNo, page);
+      used += page.page_number() == pageNo;
+    }
+  }
+  report("readPageInto() scan", double(kPasses) * (kFilePages - 1),
+         timer.seconds());
+  if (used == 0) std::printf("no pages read\n");
+}
+
+/**
+ * Reads the whole file kPasses times with readPages() runs of the given
+ * length.
+ */
+void runReadRuns(File &file, const PageId runPages) {
+  std::vector<Page> pages(runPages);
+  std::vector<Page *> targets;
+  for (Page &page : pages) targets.push_back(&page);
+  std::size_t read = 0;
+  Timer timer;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    for (PageId first = 1; first < kFilePages; first += runPages) {
+      read += file.readPages(first, runPages, targets.data());
+    }
+  }
+  report("readPages() scan, runs of " + std::to_string(runPages), double(read),
+         timer.seconds());
+}
+
+/**
+ * Reads batches of kBatchPages random pages, sorted, one page at a time or
+ * with the scattering readPages().
+ */
+void runBatches(File &file, const bool scatter) {
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> pick(1, kFilePages - 1);
+  std::vector<Page> pages(kBatchPages);
+  std::vector<Page *> targets;
+  for (Page &page : pages) targets.push_back(&page);
+  std::vector<PageId> pageNos(kBatchPages);
+  Timer timer;
+  for (int batch = 0; batch < kBatches; ++batch) {
+    // Clustered, as from an index range: a random start, then gaps of 0-3.
+    PageId pageNo = pick(rng) % (kFilePages - 4 * kBatchPages) + 1;
+    for (PageId &next : pageNos) {
+      next = pageNo;
+      pageNo += 1 + rng() % 4;
+    }
+    if (scatter) {
+      file.readPages(pageNos.data(), pageNos.size(), targets.data());
+    } else {
+      for (std::uint32_t i = 0; i < kBatchPages; ++i) {
+        pages[i] = file.readPage(pageNos[i]);
+      }
+    }
+  }
+  report(scatter ? "batch lookups, scattering readPages()"
+                 : "batch lookups, readPage() each",
+         double(kBatches) * kBatchPages, timer.seconds());
+}
+
+}  // namespace
+
+void readPagesBench() {
+  const std::string filename = "bench.read_pages";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    file.allocatePages(kFilePages - 1);
+  }
+  {
+    File file = File::open(filename, FileBackend::POSIX);
+    runReadPage(file);
+    runReadPageInto(file);
+    const PageId runs[] = {8, 32, 128};
+    for (PageId runPages : runs) runReadRuns(file, runPages);
+    runBatches(file, false);
+    runBatches(file, true);
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
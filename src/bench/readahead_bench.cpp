@@ -0,0 +1,70 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const std::uint32_t kPoolFrames = 256;
+const int kPasses = 8;
+
+/**
+ * Scans the whole file kPasses times through a pool much smaller than the
+ * file, so that every page read misses.
+ */
+void runColdScan(File &file, std::uint32_t maxReadAhead, bool useRing) {
+  BufMgr bufMgr(kPoolFrames);
+  bufMgr.setMaxReadAhead(maxReadAhead);
+  BufAccessStrategy ring;
+  BufAccessStrategy *strategy = useRing ? &ring : nullptr;
+  Page *page;
+
+  Timer timer;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    for (PageId pageNo = 1; pageNo < kFilePages; ++pageNo) {
+      bufMgr.readPage(file, pageNo, page, strategy);
+      bufMgr.unPinPage(file, pageNo, false);
+    }
+  }
+  const double seconds = timer.seconds();
+
+  const BufStats stats = bufMgr.getBufStats();
+  report("read-ahead " + std::to_string(maxReadAhead) +
+             (useRing ? " ring" : ""),
+         double(kPasses) * (kFilePages - 1), seconds);
+  std::printf("  %6.1f MB/s  disk reads %d  prefetched %d\n",
+              kPasses * (kFilePages - 1) * double(Page::SIZE) / seconds / 1e6,
+              stats.diskreads, stats.prefetched);
+}
+
+}  // namespace
+
+void readAheadBench() {
+  const std::string filename = "bench.readahead";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 1; i < kFilePages; ++i) file.allocatePage();
+
+    const std::uint32_t windows[] = {0, 8, 32};
+    for (std::uint32_t window : windows) runColdScan(file, window, false);
+    runColdScan(file, 32, true);
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
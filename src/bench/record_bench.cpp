@@ -0,0 +1,184 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench/bench.h"
+#include "buffer.h"
+#include "page_iterator.h"
+
+namespace {
+
+/**
+ * Heap allocations made by the calling thread, counted by the replacement
+ * operator new below.
+ */
+thread_local std::size_t allocations = 0;
+
+}  // namespace
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (void *p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 1024;
+const std::size_t kRecordSize = 48;
+const int kPasses = 8;
+const int kLookups = 1000000;
+
+/**
+ * Scans every record of the file kPasses times through a pool that holds it
+ * all, copying each record or viewing it in place.
+ */
+void runScan(BufMgr &bufMgr, File &file, const bool views) {
+  std::size_t records = 0;
+  std::size_t bytes = 0;
+  const std::size_t allocationsBefore = allocations;
+  Page *page;
+  Timer timer;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    for (PageId pageNo = 1; pageNo < kFilePages; ++pageNo) {
+      bufMgr.readPage(file, pageNo, page);
+      for (PageIterator it = page->begin(); it != page->end(); ++it) {
+        bytes += views ? it.view().size() : (*it).size();
+        ++records;
+      }
+      bufMgr.unPinPage(file, pageNo, false);
+    }
+  }
+  report(views ? "scan, PageIterator::view()" : "scan, PageIterator copies",
+         double(records), timer.seconds());
+  std::printf("  %.3f allocations per record  %zu bytes\n",
+              double(allocations - allocationsBefore) / records, bytes);
+}
+
+/**
+ * Looks up random records through the pool, copying each one or viewing it
+ * in place.
+ */
+void runLookups(BufMgr &bufMgr, File &file, const SlotId slotsPerPage,
+                const bool views) {
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> pickPage(1, kFilePages - 1);
+  std::uniform_int_distribution<SlotId> pickSlot(1, slotsPerPage);
+  std::size_t bytes = 0;
+  Page *page;
+  // Drawn up front so that the counts only cover the lookups.
+  std::vector<RecordId> ids(kLookups);
+  for (RecordId &id : ids) id = {pickPage(rng), pickSlot(rng)};
+  const std::size_t allocationsBefore = allocations;
+  Timer timer;
+  for (const RecordId &id : ids) {
+    bufMgr.readPage(file, id.page_number, page);
+    bytes += views ? page->viewRecord(id).size() : page->getRecord(id).size();
+    bufMgr.unPinPage(file, id.page_number, false);
+  }
+  report(views ? "lookups, Page::viewRecord()" : "lookups, Page::getRecord()",
+         kLookups, timer.seconds());
+  std::printf("  %.3f allocations per record  %zu bytes\n",
+              double(allocations - allocationsBefore) / kLookups, bytes);
+}
+
+/**
+ * Fills pages with records and deletes them all, first inserted first, then
+ * fills them again, as a delete-heavy workload would.
+ */
+void runDeletes() {
+  const std::string record(kRecordSize, 'd');
+  const int kPages = 2000;
+  std::vector<RecordId> ids;
+  std::size_t deletes = 0;
+  Page page;
+  Timer timer;
+  for (int i = 0; i < kPages; ++i) {
+    ids.clear();
+    while (page.hasSpaceForRecord(record)) {
+      ids.push_back(page.insertRecord(record));
+    }
+    for (const RecordId &id : ids) page.deleteRecord(id);
+    deletes += ids.size();
+  }
+  report("fill and delete whole pages", double(deletes), timer.seconds());
+}
+
+void runSlotReuse() {
+  const std::string record(kRecordSize, 's');
+  const int kRounds = 2000000;
+  Page page;
+  std::vector<RecordId> ids;
+  while (page.getFreeSpace() > Page::DATA_SIZE / 2) {
+    ids.push_back(page.insertRecord(record));
+  }
+  // Free and refill slots near the end of the slot array, but never the last
+  // slot, which would be dropped rather than kept for reuse.  Half the page
+  // is left free so that compaction is rare.
+  const std::size_t reused = std::min<std::size_t>(16, ids.size() - 1);
+  Timer timer;
+  for (int i = 0; i < kRounds; ++i) {
+    RecordId &id = ids[ids.size() - 2 - i % reused];
+    page.deleteRecord(id);
+    id = page.insertRecord(record);
+  }
+  report("delete and reinsert into freed slot", double(kRounds),
+         timer.seconds());
+}
+
+}  // namespace
+
+void recordBench() {
+  const std::string filename = "bench.record";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    const std::string record(kRecordSize, 'r');
+    SlotId slotsPerPage = 0;
+    for (std::uint32_t i = 1; i < kFilePages; ++i) {
+      Page page = file.allocatePage();
+      SlotId slots = 0;
+      while (page.hasSpaceForRecord(record)) {
+        page.insertRecord(record);
+        ++slots;
+      }
+      slotsPerPage = slots;
+      file.writePage(page);
+    }
+    std::printf("%u records of %zu bytes per page\n",
+                static_cast<unsigned>(slotsPerPage), kRecordSize);
+
+    BufMgr bufMgr(kFilePages);
+    bufMgr.setMaxReadAhead(0);
+    runScan(bufMgr, file, false);
+    runScan(bufMgr, file, true);
+    runLookups(bufMgr, file, slotsPerPage, false);
+    runLookups(bufMgr, file, slotsPerPage, true);
+    bufMgr.flushFile(file);
+  }
+  File::remove(filename);
+  runDeletes();
+  runSlotReuse();
+}
+
+}  // namespace bench
+}  // namespace badgerdb
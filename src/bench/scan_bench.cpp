@@ -0,0 +1,96 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "bench/bench.h"
+#include "buffer.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const std::uint32_t kFilePages = 2048;
+const std::uint32_t kPoolFrames = 512;
+const std::uint32_t kHotPages = 384;
+const int kRounds = 40;
+const int kLookupsPerRound = 2000;
+const std::uint32_t kScanPagesPerRound = 256;
+
+/**
+ * Alternates batches of point lookups on a hot set that fits in the pool with
+ * chunks of a sequential scan over the whole file, as a lookup workload and a
+ * concurrent scan would interleave.  Lookup and scan costs are measured
+ * separately.
+ */
+void runScanMix(File &file, ReplacementPolicyType type, bool useRing) {
+  BufMgr bufMgr(kPoolFrames, type);
+  BufAccessStrategy ring;
+  BufAccessStrategy *strategy = useRing ? &ring : nullptr;
+  std::minstd_rand rng(1);
+  std::uniform_int_distribution<PageId> hot(1, kHotPages);
+  Page *page;
+
+  for (PageId pageNo = 1; pageNo <= kHotPages; ++pageNo) {
+    bufMgr.readPage(file, pageNo, page);
+    bufMgr.unPinPage(file, pageNo, false);
+  }
+
+  int lookupReads = 0;
+  double scanSeconds = 0;
+  PageId scanPos = 1;
+  for (int round = 0; round < kRounds; ++round) {
+    const int readsBefore = bufMgr.getBufStats().diskreads;
+    for (int i = 0; i < kLookupsPerRound; ++i) {
+      const PageId pageNo = hot(rng);
+      bufMgr.readPage(file, pageNo, page);
+      bufMgr.unPinPage(file, pageNo, false);
+    }
+    lookupReads += bufMgr.getBufStats().diskreads - readsBefore;
+
+    Timer timer;
+    for (std::uint32_t i = 0; i < kScanPagesPerRound; ++i) {
+      bufMgr.readPage(file, scanPos, page, strategy);
+      bufMgr.unPinPage(file, scanPos, false);
+      scanPos = scanPos % kFilePages + 1;
+    }
+    scanSeconds += timer.seconds();
+  }
+
+  const double lookups = double(kRounds) * kLookupsPerRound;
+  const std::string name =
+      std::string(bufMgr.getReplacementPolicyName()) +
+      (useRing ? " ring=" + std::to_string(ring.ringSize()) : " no ring");
+  report(name + " scan", double(kRounds) * kScanPagesPerRound, scanSeconds);
+  std::printf("  lookup hit ratio %6.3f\n", 1 - lookupReads / lookups);
+}
+
+}  // namespace
+
+void scanBench() {
+  const std::string filename = "bench.scan";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    for (std::uint32_t i = 0; i < kFilePages; ++i) file.allocatePage();
+
+    const ReplacementPolicyType types[] = {ReplacementPolicyType::CLOCK,
+                                           ReplacementPolicyType::ARC};
+    for (ReplacementPolicyType type : types) {
+      runScanMix(file, type, false);
+      runScanMix(file, type, true);
+    }
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
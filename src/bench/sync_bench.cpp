@@ -0,0 +1,76 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench/bench.h"
+
+namespace badgerdb {
+namespace bench {
+
+namespace {
+
+const int kCommitsPerThread = 200;
+
+/**
+ * Has each of <threads> threads commit by writing a page of its own and
+ * syncing the file.
+ */
+void runCommits(File &file, const std::vector<Page> &pages, int threads,
+                const std::string &name) {
+  const std::uint64_t syncsBefore = file.deviceSyncs();
+  std::vector<std::thread> workers;
+  Timer timer;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&file, &pages, t]() {
+      for (int i = 0; i < kCommitsPerThread; ++i) {
+        file.writePage(pages[t]);
+        file.sync();
+      }
+    });
+  }
+  for (std::thread &worker : workers) worker.join();
+  const int commits = threads * kCommitsPerThread;
+  report(name + " threads=" + std::to_string(threads) + " device syncs=" +
+             std::to_string(file.deviceSyncs() - syncsBefore),
+         commits, timer.seconds());
+}
+
+}  // namespace
+
+void syncBench() {
+  const std::string filename = "bench.sync";
+  removeIfExists(filename);
+  {
+    File file = File::create(filename);
+    const PageRun run = file.allocatePages(8);
+    std::vector<Page> pages;
+    for (PageId i = 0; i < run.count; ++i) {
+      pages.push_back(file.readPage(run.first + i));
+    }
+    const struct {
+      SyncPolicy policy;
+      const char *name;
+    } policies[] = {{SyncPolicy::NONE, "none"},
+                    {SyncPolicy::FLUSH, "flush"},
+                    {SyncPolicy::DATASYNC, "fdatasync"},
+                    {SyncPolicy::FSYNC, "fsync"}};
+    for (const auto &policy : policies) {
+      file.setSyncPolicy(policy.policy);
+      for (int threads = 1; threads <= 8; threads *= 8) {
+        runCommits(file, pages, threads, policy.name);
+      }
+    }
+  }
+  File::remove(filename);
+}
+
+}  // namespace bench
+}  // namespace badgerdb
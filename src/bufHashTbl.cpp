@@ -8,9 +8,9 @@
 
 #include "bufHashTbl.h"
 
-#include <functional>
+#include <algorithm>
 #include <iostream>
-#include <memory>
+#include <new>
 
 #include "buffer.h"
 #include "exceptions/hash_already_present_exception.h"
@@ -19,74 +19,167 @@
 
 namespace badgerdb {
 
-int BufHashTbl::hash(const File& file, const PageId pageNo) {
-  auto hash =
-      std::hash<std::string>{}(file.filename()) ^ std::hash<PageId>{}(pageNo);
-  return hash % HTSIZE;
+namespace {
+
+/**
+ * Returns the smallest power of two that is at least n.
+ */
+std::uint32_t roundUpToPowerOfTwo(std::uint32_t n) {
+  std::uint32_t power = 1;
+  while (power < n) power <<= 1;
+  return power;
+}
+
+}  // namespace
+
+std::uint64_t BufHashTbl::hash(const FileId fileId, const PageId pageNo) {
+  // Mix both keys with a multiplicative (Fibonacci) hash so that consecutive
+  // page numbers spread over partitions and slots.
+  std::uint64_t hash = (static_cast<std::uint64_t>(fileId) << 32) | pageNo;
+  hash *= 0x9E3779B97F4A7C15ull;
+  return hash ^ (hash >> 29);
+}
+
+BufHashTbl::BufHashTbl(int htSize)
+    : HTSIZE(htSize),
+      numPartitions(std::min<std::uint32_t>(
+          NUM_PARTITIONS, roundUpToPowerOfTwo((htSize + 15) / 16))),
+      partitions(numPartitions) {
+  // Give every partition room for twice its share of the table, so that the
+  // load factor stays below one half unless pages cluster on one partition.
+  const std::uint32_t slotsPerPartition =
+      roundUpToPowerOfTwo(2 * ((htSize + numPartitions - 1) / numPartitions));
+  for (Partition& partition : partitions) {
+    partition.slots.assign(slotsPerPartition,
+                           hashBucket{0, Page::INVALID_NUMBER, 0});
+    partition.count = 0;
+  }
 }
 
-BufHashTbl::BufHashTbl(int htSize) : HTSIZE(htSize), ht(htSize) {
-  // allocate an array of pointers to hashBuckets
+std::mutex& BufHashTbl::partitionLatch(const File& file, const PageId pageNo) {
+  return partitionLatch(file.id(), pageNo);
+}
+
+std::mutex& BufHashTbl::partitionLatch(const FileId fileId,
+                                       const PageId pageNo) {
+  return partitionFor(hash(fileId, pageNo)).latch;
+}
+
+std::size_t BufHashTbl::probe(const Partition& partition,
+                              const std::uint64_t hashValue,
+                              const FileId fileId, const PageId pageNo) {
+  const std::size_t mask = partition.slots.size() - 1;
+  std::size_t index = hashValue & mask;
+  while (true) {
+    const hashBucket& bucket = partition.slots[index];
+    if (bucket.pageNo == Page::INVALID_NUMBER ||
+        (bucket.pageNo == pageNo && bucket.fileId == fileId))
+      return index;
+    index = (index + 1) & mask;
+  }
+}
+
+void BufHashTbl::grow(Partition& partition) {
+  std::vector<hashBucket> old;
+  try {
+    old.swap(partition.slots);
+    partition.slots.assign(2 * old.size(),
+                           hashBucket{0, Page::INVALID_NUMBER, 0});
+  } catch (const std::bad_alloc&) {
+    partition.slots.swap(old);
+    throw HashTableException();
+  }
+  const std::size_t mask = partition.slots.size() - 1;
+  for (const hashBucket& bucket : old) {
+    if (bucket.pageNo == Page::INVALID_NUMBER) continue;
+    std::size_t index = hash(bucket.fileId, bucket.pageNo) & mask;
+    while (partition.slots[index].pageNo != Page::INVALID_NUMBER)
+      index = (index + 1) & mask;
+    partition.slots[index] = bucket;
+  }
+}
+
+Status BufHashTbl::tryInsert(const File& file, const PageId pageNo,
+                             const FrameId frameNo) {
+  const std::uint64_t hashValue = hash(file.id(), pageNo);
+  Partition& partition = partitionFor(hashValue);
+
+  std::size_t index = probe(partition, hashValue, file.id(), pageNo);
+  if (partition.slots[index].pageNo != Page::INVALID_NUMBER)
+    return Status::HASH_ALREADY_PRESENT;
+
+  // Keep the load factor at or below three quarters.
+  if (4 * (partition.count + 1) > 3 * partition.slots.size()) {
+    grow(partition);
+    index = probe(partition, hashValue, file.id(), pageNo);
+  }
+
+  partition.slots[index] = hashBucket{file.id(), pageNo, frameNo};
+  ++partition.count;
+  return Status::OK;
 }
 
 void BufHashTbl::insert(const File& file, const PageId pageNo,
                         const FrameId frameNo) {
-  int index = hash(file, pageNo);
-
-  std::shared_ptr<hashBucket> tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo)
-      throw HashAlreadyPresentException(tmpBuc->file.filename(), tmpBuc->pageNo,
-                                        tmpBuc->frameNo);
-    tmpBuc = tmpBuc->next;
+  if (tryInsert(file, pageNo, frameNo) != Status::OK) {
+    FrameId existing;
+    tryLookup(file, pageNo, existing);
+    throw HashAlreadyPresentException(file.filename(), pageNo, existing);
   }
+}
 
-  tmpBuc = std::make_shared<hashBucket>();
-  if (!tmpBuc) throw HashTableException();
+Status BufHashTbl::tryLookup(const File& file, const PageId pageNo,
+                             FrameId& frameNo) {
+  const std::uint64_t hashValue = hash(file.id(), pageNo);
+  const Partition& partition = partitionFor(hashValue);
+  const hashBucket& bucket =
+      partition.slots[probe(partition, hashValue, file.id(), pageNo)];
+  if (bucket.pageNo == Page::INVALID_NUMBER) return Status::HASH_NOT_FOUND;
 
-  tmpBuc->file = file;
-  tmpBuc->pageNo = pageNo;
-  tmpBuc->frameNo = frameNo;
-  tmpBuc->next = ht[index];
-  ht[index] = tmpBuc;
+  frameNo = bucket.frameNo;  // return frameNo by reference
+  return Status::OK;
 }
 
 void BufHashTbl::lookup(const File& file, const PageId pageNo,
                         FrameId& frameNo) {
-  int index = hash(file, pageNo);
-  std::shared_ptr<hashBucket> tmpBuc = ht[index];
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo) {
-      frameNo = tmpBuc->frameNo;  // return frameNo by reference
-      return;
-    }
-    tmpBuc = tmpBuc->next;
-  }
-
-  throw HashNotFoundException(file.filename(), pageNo);
+  if (tryLookup(file, pageNo, frameNo) != Status::OK)
+    throw HashNotFoundException(file.filename(), pageNo);
 }
 
 void BufHashTbl::remove(const File& file, const PageId pageNo) {
-  int index = hash(file, pageNo);
-  std::shared_ptr<hashBucket> tmpBuc = ht[index];
-  std::shared_ptr<hashBucket> prevBuc;
-
-  while (tmpBuc) {
-    if (tmpBuc->file == file && tmpBuc->pageNo == pageNo) {
-      if (prevBuc)
-        prevBuc->next = tmpBuc->next;
-      else
-        ht[index] = tmpBuc->next;
-
-      tmpBuc.reset();
-      return;
-    } else {
-      prevBuc = tmpBuc;
-      tmpBuc = tmpBuc->next;
+  if (tryRemove(file, pageNo) != Status::OK)
+    throw HashNotFoundException(file.filename(), pageNo);
+}
+
+Status BufHashTbl::tryRemove(const File& file, const PageId pageNo) {
+  return tryRemove(file.id(), pageNo);
+}
+
+Status BufHashTbl::tryRemove(const FileId fileId, const PageId pageNo) {
+  const std::uint64_t hashValue = hash(fileId, pageNo);
+  Partition& partition = partitionFor(hashValue);
+  std::size_t hole = probe(partition, hashValue, fileId, pageNo);
+  if (partition.slots[hole].pageNo == Page::INVALID_NUMBER)
+    return Status::HASH_NOT_FOUND;
+
+  // Backward-shift deletion: pull later entries of the probe run into the hole
+  // unless that would move them before their home slot.
+  const std::size_t mask = partition.slots.size() - 1;
+  std::size_t index = hole;
+  while (true) {
+    index = (index + 1) & mask;
+    hashBucket& bucket = partition.slots[index];
+    if (bucket.pageNo == Page::INVALID_NUMBER) break;
+    const std::size_t home = hash(bucket.fileId, bucket.pageNo) & mask;
+    // Move the entry if its home slot is not cyclically within (hole, index].
+    if (((index - home) & mask) >= ((index - hole) & mask)) {
+      partition.slots[hole] = bucket;
+      hole = index;
     }
   }
-
-  throw HashNotFoundException(file.filename(), pageNo);
+  partition.slots[hole].pageNo = Page::INVALID_NUMBER;
+  --partition.count;
+  return Status::OK;
 }
 
 }  // namespace badgerdb
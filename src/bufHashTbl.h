@@ -8,20 +8,25 @@
 
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include "file.h"
+#include "status.h"
 
 namespace badgerdb {
 
 /**
  * @brief Declarations for buffer pool hash table
+ *
+ * One slot of the open-addressing table.  A slot is empty when its pageNo is
+ * Page::INVALID_NUMBER.
  */
 struct hashBucket {
   /**
-   * pointer a file object (more on this below)
+   * id of the file the page belongs to
    */
-  File file;
+  FileId fileId;
 
   /**
    * page number within a file
@@ -32,37 +37,94 @@ struct hashBucket {
    * frame number of page in the buffer pool
    */
   FrameId frameNo;
-
-  /**
-   * Next node in the hash table
-   */
-  std::shared_ptr<hashBucket> next;
 };
 
 /**
  * @brief Hash table class to keep track of pages in the buffer pool
  *
- * @warning This class is not threadsafe.
+ * The table is split into partitions, each an independently latched
+ * open-addressing array using linear probing (with backward-shift deletion, so
+ * there are no tombstones).  All slots are allocated up front, sized from the
+ * table size given to the constructor; insert(), lookup() and remove() do not
+ * allocate unless a partition receives far more than its share of entries.
+ *
+ * The table does not take the partition latches itself: callers lock
+ * partitionLatch() for the (file, pageNo) they operate on, so that they can act
+ * on the result of a lookup (e.g. pin the frame) before the entry can be
+ * removed by another thread.
  */
 class BufHashTbl {
+ public:
+  /**
+   * Maximum number of independently latched partitions.
+   */
+  static const int NUM_PARTITIONS = 64;
+
  private:
+  /**
+   * @brief One latched open-addressing array.
+   */
+  struct Partition {
+    /**
+     * Latch guarding slots and count.
+     */
+    std::mutex latch;
+
+    /**
+     * Slots of the table; the size is a power of two.
+     */
+    std::vector<hashBucket> slots;
+
+    /**
+     * Number of occupied slots.
+     */
+    std::uint32_t count;
+  };
+
   /**
    *	Size of Hash Table
    */
   int HTSIZE;
+
+  /**
+   * Number of partitions actually used (a power of two).
+   */
+  std::uint32_t numPartitions;
+
   /**
    * Actual Hash table object
    */
-  std::vector<std::shared_ptr<hashBucket>> ht;
+  std::vector<Partition> partitions;
 
   /**
-   * returns hash value between 0 and HTSIZE-1 computed using file and pageNo
+   * returns a 64-bit hash computed using fileId and pageNo.  The high half
+   * picks the partition and the low half the home slot within it.
    *
-   * @param file   	File object
+   * @param fileId  Id of the file
    * @param pageNo  Page number in the file
    * @return  			Hash value.
    */
-  int hash(const File& file, const PageId pageNo);
+  static std::uint64_t hash(const FileId fileId, const PageId pageNo);
+
+  /**
+   * Returns the partition a hash value belongs to.
+   */
+  Partition& partitionFor(const std::uint64_t hashValue) {
+    return partitions[(hashValue >> 32) & (numPartitions - 1)];
+  }
+
+  /**
+   * Returns the index of the slot holding (fileId, pageNo) in the partition,
+   * or of the empty slot ending its probe sequence if it is absent.
+   */
+  static std::size_t probe(const Partition& partition,
+                           const std::uint64_t hashValue,
+                           const FileId fileId, const PageId pageNo);
+
+  /**
+   * Doubles the number of slots of a partition and reinserts its entries.
+   */
+  void grow(Partition& partition);
 
  public:
   /**
@@ -70,6 +132,26 @@ class BufHashTbl {
    */
   BufHashTbl(const int htSize);  // constructor
 
+  /**
+   * Returns the latch guarding the partition that (file, pageNo) hashes to.
+   * It must be held across insert(), lookup() and remove() for that key.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   * @return  			Partition latch.
+   */
+  std::mutex& partitionLatch(const File& file, const PageId pageNo);
+
+  /**
+   * Returns the latch guarding the partition that (fileId, pageNo) hashes to,
+   * as partitionLatch() does for a File object.
+   *
+   * @param fileId  Id of the file
+   * @param pageNo  Page number in the file
+   * @return  			Partition latch.
+   */
+  std::mutex& partitionLatch(const FileId fileId, const PageId pageNo);
+
   /**
    * Insert entry into hash table mapping (file, pageNo) to frameNo.
    *
@@ -83,6 +165,20 @@ class BufHashTbl {
    */
   void insert(const File& file, const PageId pageNo, const FrameId frameNo);
 
+  /**
+   * Non-throwing variant of insert().
+   *
+   * @param file   	File object
+   * @param pageNo 	Page number in the file
+   * @param frameNo Frame number assigned to that page of the file
+   * @return  Status::HASH_ALREADY_PRESENT if the corresponding page already
+   * exists in the hash table, Status::OK otherwise.
+   * @throws  HashTableException if a partition had to grow and ran out of
+   * memory
+   */
+  Status tryInsert(const File& file, const PageId pageNo,
+                   const FrameId frameNo);
+
   /**
    * Check if (file, pageNo) is currently in the buffer pool (ie. in
    * the hash table).
@@ -95,6 +191,18 @@ class BufHashTbl {
    */
   void lookup(const File& file, const PageId pageNo, FrameId& frameNo);
 
+  /**
+   * Non-throwing variant of lookup(); this is how buffer pool misses are
+   * detected.
+   *
+   * @param file  	File object
+   * @param pageNo	Page number in the file
+   * @param frameNo Frame number reference, only set if the entry is found
+   * @return  Status::HASH_NOT_FOUND if the page entry is not found in the hash
+   * table, Status::OK otherwise.
+   */
+  Status tryLookup(const File& file, const PageId pageNo, FrameId& frameNo);
+
   /**
    * Delete entry (file,pageNo) from hash table.
    *
@@ -104,6 +212,26 @@ class BufHashTbl {
    * table
    */
   void remove(const File& file, const PageId pageNo);
+
+  /**
+   * Non-throwing variant of remove().
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   * @return  Status::HASH_NOT_FOUND if the page entry is not found in the hash
+   * table, Status::OK otherwise.
+   */
+  Status tryRemove(const File& file, const PageId pageNo);
+
+  /**
+   * Non-throwing variant of remove() for a file known by its id.
+   *
+   * @param fileId  Id of the file
+   * @param pageNo  Page number in the file
+   * @return  Status::HASH_NOT_FOUND if the page entry is not found in the hash
+   * table, Status::OK otherwise.
+   */
+  Status tryRemove(const FileId fileId, const PageId pageNo);
 };
 
 }  // namespace badgerdb
@@ -8,49 +8,778 @@
 
 #include "buffer.h"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
-#include "exceptions/hash_not_found_exception.h"
+#include "exceptions/file_io_exception.h"
+#include "exceptions/invalid_page_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 
 namespace badgerdb {
 
+PinnedPage::PinnedPage(PinnedPage&& other) noexcept
+    : bufMgr(other.bufMgr), frame(other.frame), dirty(other.dirty) {
+  other.bufMgr = nullptr;
+}
+
+PinnedPage& PinnedPage::operator=(PinnedPage&& other) noexcept {
+  if (this != &other) {
+    release();
+    bufMgr = other.bufMgr;
+    frame = other.frame;
+    dirty = other.dirty;
+    other.bufMgr = nullptr;
+  }
+  return *this;
+}
+
+Page* PinnedPage::get() const {
+  return bufMgr != nullptr ? &bufMgr->bufPool[frame] : nullptr;
+}
+
+void PinnedPage::release() {
+  if (bufMgr == nullptr) return;
+  bufMgr->unPinFrame(frame, dirty);
+  bufMgr = nullptr;
+}
+
+BufAccessStrategy::BufAccessStrategy(std::uint32_t ringSize)
+    : ring(std::max<std::uint32_t>(ringSize, 1),
+           Slot{0, File::INVALID_ID, Page::INVALID_NUMBER}),
+      current(0),
+      ringReuses(0) {}
+
+void BufAccessStrategy::recordLoad(FrameId frame, FileId fileId,
+                                   PageId pageNo) {
+  ring[current] = Slot{frame, fileId, pageNo};
+  current = (current + 1) % ring.size();
+}
+
 constexpr int HASHTABLE_SZ(int bufs) { return ((int)(bufs * 1.2) & -2) + 1; }
 
 //----------------------------------------
 // Constructor of the class BufMgr
 //----------------------------------------
 
-BufMgr::BufMgr(std::uint32_t bufs)
+const std::uint32_t BufMgr::READ_AHEAD_MIN;
+const std::uint32_t BufMgr::READ_AHEAD_MAX;
+
+BufMgr::BufMgr(std::uint32_t bufs, ReplacementPolicyType policyType)
     : numBufs(bufs),
       hashTable(HASHTABLE_SZ(bufs)),
       bufDescTable(bufs),
+      policy(ReplacementPolicy::create(policyType, bufs)),
+      maxReadAhead(0),
+      bgWriterRunning(false),
+      bgWriterStop(false),
+      bgWriterKicked(false),
+      bgWriterTarget(0),
+      bgWriterInterval(0),
+      ioEngine(IOEngine::create()),
       bufPool(bufs) {
   for (FrameId i = 0; i < bufs; i++) {
     bufDescTable[i].frameNo = i;
     bufDescTable[i].valid = false;
   }
+}
+
+BufMgr::~BufMgr() {
+  stopBackgroundWriter();
+  for (FrameId i = 0; i < numBufs; i++) {
+    BufDesc& desc = bufDescTable[i];
+    if (desc.valid && desc.dirty) {
+      desc.dirty = false;
+      try {
+        File::writePageFrom(*desc.openFile, bufPool[i]);
+      } catch (const InvalidPageException&) {
+        // Deleted from the file directly, not through disposePage().
+      } catch (const FileIOException&) {
+        // Nowhere to report it from here.
+      }
+    }
+  }
+}
+
+Status BufMgr::allocBuf(FrameId& frame, BufAccessStrategy* strategy) {
+  if (strategy != nullptr && claimRingFrame(*strategy, frame))
+    return Status::OK;
+
+  const ReplacementPolicy::ClaimFn tryClaim = [this](FrameId candidate) {
+    return tryClaimFrame(candidate);
+  };
+
+  for (std::uint32_t attempt = 0; attempt < numBufs; attempt++) {
+    FrameId candidate;
+    if (!policy->pickVictim(tryClaim, candidate)) break;
+    BufDesc& desc = bufDescTable[candidate];
+    std::unique_lock<std::mutex> frameLatch(desc.latch, std::adopt_lock);
+
+    bool evicted;
+    try {
+      evicted = evictPage(candidate);
+    } catch (...) {
+      policy->frameRestored(candidate);
+      throw;
+    }
+    if (!evicted) {
+      policy->frameRestored(candidate);
+      continue;
+    }
+
+    desc.clear();
+    frame = candidate;
+    frameLatch.release();  // the caller now owns the frame latch
+    return Status::OK;
+  }
+
+  return Status::BUFFER_EXCEEDED;
+}
+
+bool BufMgr::tryClaimFrame(const FrameId frame) {
+  BufDesc& desc = bufDescTable[frame];
+  if (desc.pinCnt > 0 || !desc.latch.try_lock()) return false;
+  if (desc.pinCnt > 0) {
+    desc.latch.unlock();
+    return false;
+  }
+  return true;
+}
+
+bool BufMgr::evictPage(const FrameId frame) {
+  BufDesc& desc = bufDescTable[frame];
+  if (!desc.valid) return true;
+
+  // Write back while the page is still reachable through the hash table, so
+  // that nobody re-reads a stale copy from disk in the meantime.
+  if (desc.dirty.exchange(false)) {
+    try {
+      File::writePageFrom(*desc.openFile, bufPool[frame]);
+    } catch (...) {
+      desc.dirty = true;
+      throw;
+    }
+    localStats().diskwrites++;
+    localStats().evictwrites++;
+    kickBackgroundWriter();
+  }
+
+  std::lock_guard<std::mutex> partition(
+      hashTable.partitionLatch(desc.fileId, desc.pageNo));
+  // Pins are only taken under the partition latch, so this check is final.
+  if (desc.pinCnt > 0 || desc.dirty) return false;
+  hashTable.tryRemove(desc.fileId, desc.pageNo);
+  return true;
+}
+
+bool BufMgr::claimRingFrame(BufAccessStrategy& strategy, FrameId& frame) {
+  const BufAccessStrategy::Slot& slot = strategy.ring[strategy.current];
+  if (slot.pageNo == Page::INVALID_NUMBER || !tryClaimFrame(slot.frameNo))
+    return false;
+  BufDesc& desc = bufDescTable[slot.frameNo];
+  std::unique_lock<std::mutex> frameLatch(desc.latch, std::adopt_lock);
+
+  // The frame may have been evicted and given to another page since.
+  if (!desc.valid || desc.fileId != slot.fileId ||
+      desc.pageNo != slot.pageNo)
+    return false;
+  if (!evictPage(slot.frameNo)) return false;
+
+  // The frame stays on the policy's lists; frameLoaded() replaces its page.
+  desc.clear();
+  frame = slot.frameNo;
+  frameLatch.release();
+  strategy.ringReuses++;
+  return true;
+}
+
+bool BufMgr::pinIfPresent(File& file, const PageId pageNo, FrameId& frame) {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> partition(
+          hashTable.partitionLatch(file, pageNo));
+      if (hashTable.tryLookup(file, pageNo, frame) != Status::OK) return false;
+      bufDescTable[frame].pinCnt++;
+    }
+
+    BufDesc& desc = bufDescTable[frame];
+    if (!desc.valid.load(std::memory_order_acquire)) {
+      // Another thread is still reading the page in; its frame latch is
+      // released once the read is done.
+      { std::lock_guard<std::mutex> frameLatch(desc.latch); }
+    }
+    if (desc.valid) {
+      policy->frameAccessed(frame);
+      return true;
+    }
+
+    // That read failed and the frame was abandoned; retry as a miss.
+    desc.pinCnt--;
+  }
+}
+
+void BufMgr::abandonFrame(File& file, const PageId pageNo,
+                          const FrameId frame) {
+  BufDesc& desc = bufDescTable[frame];
+  std::lock_guard<std::mutex> partition(hashTable.partitionLatch(file, pageNo));
+  hashTable.tryRemove(file, pageNo);
+  desc.fileId = File::INVALID_ID;
+  desc.openFile.reset();
+  desc.pageNo = Page::INVALID_NUMBER;
+  // Threads that pinned the frame while we were reading drop their own pins
+  // once they see it is invalid.
+  desc.pinCnt--;
+  policy->frameFreed(frame);
+}
+
+void BufMgr::readPage(File& file, const PageId pageNo, Page*& page,
+                      BufAccessStrategy* strategy) {
+  switch (tryReadPage(file, pageNo, page, strategy)) {
+    case Status::INVALID_PAGE:
+      throw InvalidPageException(pageNo, file.filename());
+    case Status::BUFFER_EXCEEDED:
+      throw BufferExceededException();
+    default:
+      break;
+  }
+}
+
+Status BufMgr::tryReadPage(File& file, const PageId pageNo, Page*& page,
+                           BufAccessStrategy* strategy) {
+  FrameId frame;
+  const Status status = fetchPage(file, pageNo, strategy, frame);
+  if (status == Status::OK) page = &bufPool[frame];
+  return status;
+}
+
+PinnedPage BufMgr::readPage(File& file, const PageId pageNo,
+                            BufAccessStrategy* strategy) {
+  FrameId frame;
+  switch (fetchPage(file, pageNo, strategy, frame)) {
+    case Status::INVALID_PAGE:
+      throw InvalidPageException(pageNo, file.filename());
+    case Status::BUFFER_EXCEEDED:
+      throw BufferExceededException();
+    default:
+      return PinnedPage(this, frame);
+  }
+}
+
+Status BufMgr::fetchPage(File& file, const PageId pageNo,
+                         BufAccessStrategy* strategy, FrameId& frame) {
+  localStats().accesses++;
+
+  bool missed = false;
+  std::uint32_t readAhead = 0;
+  std::uint32_t prefetched = 0;
+  while (!pinIfPresent(file, pageNo, frame)) {
+    if (!missed) {
+      missed = true;
+      readAhead = readAheadWindow(file, pageNo, strategy);
+    }
+    const Status allocStatus = allocBuf(frame, strategy);
+    if (allocStatus != Status::OK) return allocStatus;
+    BufDesc& desc = bufDescTable[frame];
+    std::unique_lock<std::mutex> frameLatch(desc.latch, std::adopt_lock);
+
+    {
+      std::lock_guard<std::mutex> partition(
+          hashTable.partitionLatch(file, pageNo));
+      // If another thread brought the page in meanwhile, leave our frame free
+      // and pin theirs instead.
+      if (hashTable.tryInsert(file, pageNo, frame) != Status::OK) {
+        policy->frameFreed(frame);
+        continue;
+      }
+      desc.Set(file, pageNo);
+    }
+
+    Status readStatus;
+    try {
+      readStatus = readAhead > 0
+                       ? readWithReadAhead(file, pageNo, frame, readAhead,
+                                           strategy, prefetched)
+                       : file.tryReadPage(pageNo, bufPool[frame]);
+    } catch (...) {
+      abandonFrame(file, pageNo, frame);
+      throw;
+    }
+    if (readStatus != Status::OK) {
+      abandonFrame(file, pageNo, frame);
+      return readStatus;
+    }
+    localStats().diskreads++;
+    desc.valid.store(true, std::memory_order_release);
+    policy->frameLoaded(frame, file.id(), pageNo);
+    if (strategy != nullptr) strategy->recordLoad(frame, file.id(), pageNo);
+    recordMiss(file, pageNo, readAhead, prefetched);
+    break;
+  }
+
+  return Status::OK;
+}
+
+void BufMgr::startBackgroundWriter(std::uint32_t cleanTarget,
+                                   std::chrono::milliseconds interval) {
+  stopBackgroundWriter();
+  {
+    std::lock_guard<std::mutex> guard(bgWriterLatch);
+    bgWriterStop = false;
+    bgWriterKicked = false;
+    bgWriterTarget =
+        cleanTarget > 0 ? cleanTarget : std::max<std::uint32_t>(1, numBufs / 8);
+    bgWriterInterval = interval;
+  }
+  bgWriter = std::thread(&BufMgr::backgroundWriterLoop, this);
+  bgWriterRunning = true;
+}
+
+void BufMgr::stopBackgroundWriter() {
+  if (!bgWriter.joinable()) return;
+  {
+    std::lock_guard<std::mutex> guard(bgWriterLatch);
+    bgWriterStop = true;
+  }
+  bgWriterWake.notify_all();
+  bgWriter.join();
+  bgWriterRunning = false;
+}
 
-  clockHand = bufs - 1;
+void BufMgr::kickBackgroundWriter() {
+  if (!bgWriterRunning) return;
+  {
+    std::lock_guard<std::mutex> guard(bgWriterLatch);
+    bgWriterKicked = true;
+  }
+  bgWriterWake.notify_one();
+}
+
+void BufMgr::backgroundWriterLoop() {
+  std::unique_lock<std::mutex> guard(bgWriterLatch);
+  while (!bgWriterStop) {
+    const std::uint32_t target = bgWriterTarget;
+    bgWriterKicked = false;
+    guard.unlock();
+    cleanAhead(target);
+    guard.lock();
+    bgWriterWake.wait_for(guard, bgWriterInterval,
+                          [this]() { return bgWriterStop || bgWriterKicked; });
+  }
 }
 
-void BufMgr::advanceClock() {}
+std::uint32_t BufMgr::cleanAhead(const std::uint32_t target) {
+  struct DirtyPage {
+    FileId fileId;
+    PageId pageNo;
+    FrameId frame;
 
-void BufMgr::allocBuf(FrameId& frame) {}
+    bool operator<(const DirtyPage& rhs) const {
+      return fileId != rhs.fileId ? fileId < rhs.fileId : pageNo < rhs.pageNo;
+    }
+  };
 
-void BufMgr::readPage(File& file, const PageId pageNo, Page*& page) {}
+  // Look at twice the target: some of the next victims are pinned.
+  std::vector<FrameId> candidates;
+  policy->peekVictims(candidates, 2 * target);
+  std::vector<DirtyPage> dirtyPages;
+  std::uint32_t evictable = 0;
+  for (FrameId frame : candidates) {
+    if (evictable == target) break;
+    if (!tryClaimFrame(frame)) continue;
+    BufDesc& desc = bufDescTable[frame];
+    std::lock_guard<std::mutex> frameLatch(desc.latch, std::adopt_lock);
+    if (!desc.valid) continue;
+    ++evictable;
+    if (desc.dirty) dirtyPages.push_back({desc.fileId, desc.pageNo, frame});
+  }
+
+  std::sort(dirtyPages.begin(), dirtyPages.end());
+  std::uint32_t written = 0;
+  for (const DirtyPage& dirtyPage : dirtyPages) {
+    if (!tryClaimFrame(dirtyPage.frame)) continue;
+    BufDesc& desc = bufDescTable[dirtyPage.frame];
+    std::lock_guard<std::mutex> frameLatch(desc.latch, std::adopt_lock);
+    // The page may have been evicted or cleaned since it was listed.
+    if (!desc.valid || desc.fileId != dirtyPage.fileId ||
+        desc.pageNo != dirtyPage.pageNo || !desc.dirty.exchange(false))
+      continue;
+    try {
+      File::writePageFrom(*desc.openFile, bufPool[dirtyPage.frame]);
+    } catch (...) {
+      // Leave the page dirty; the caller that evicts it will get the error.
+      desc.dirty = true;
+      continue;
+    }
+    localStats().diskwrites++;
+    localStats().bgwrites++;
+    ++written;
+  }
+  return written;
+}
 
-void BufMgr::unPinPage(File& file, const PageId pageNo, const bool dirty) {}
+std::uint32_t BufMgr::readAheadWindow(const File& file, const PageId pageNo,
+                                      const BufAccessStrategy* strategy) {
+  std::uint32_t limit = maxReadAhead;
+  if (strategy != nullptr) limit = std::min(limit, strategy->ringSize() / 2);
+  if (limit == 0) return 0;
 
-void BufMgr::allocPage(File& file, PageId& pageNo, Page*& page) {}
+  std::lock_guard<std::mutex> guard(readAheadLatch);
+  auto found = readAheadStates.find(file.id());
+  if (found == readAheadStates.end()) return 0;
+  const ReadAheadState& state = found->second;
+  // Pages of the last window that were already buffered are skipped by the
+  // reader without a miss, so anywhere in it still continues the run.
+  if (pageNo < state.nextPage || pageNo - state.nextPage > state.window)
+    return 0;
+  return std::min(limit, state.window == 0 ? READ_AHEAD_MIN : 2 * state.window);
+}
+
+void BufMgr::recordMiss(const File& file, const PageId pageNo,
+                        const std::uint32_t window,
+                        const std::uint32_t prefetched) {
+  if (maxReadAhead == 0) return;
+  std::lock_guard<std::mutex> guard(readAheadLatch);
+  readAheadStates[file.id()] = ReadAheadState{pageNo + 1 + prefetched, window};
+}
+
+Status BufMgr::readWithReadAhead(File& file, const PageId pageNo,
+                                 const FrameId frame,
+                                 const std::uint32_t readAhead,
+                                 BufAccessStrategy* strategy,
+                                 std::uint32_t& prefetched) {
+  FrameId frames[READ_AHEAD_MAX + 1];
+  Page* pages[READ_AHEAD_MAX + 1];
+  frames[0] = frame;
+  pages[0] = &bufPool[frame];
+  std::uint32_t count = 1;
+  PageId read = 0;
+
+  try {
+    const PageId endPage = file.readHeader().num_pages;
+    const std::uint32_t wanted = std::min(readAhead, READ_AHEAD_MAX);
+    // Map a latched frame to each following page, as for a miss.
+    while (count <= wanted && pageNo + count < endPage) {
+      const PageId next = pageNo + count;
+      FrameId extra;
+      if (allocBuf(extra, strategy) != Status::OK) break;
+      BufDesc& desc = bufDescTable[extra];
+      bool mapped;
+      {
+        std::lock_guard<std::mutex> partition(
+            hashTable.partitionLatch(file, next));
+        mapped = hashTable.tryInsert(file, next, extra) == Status::OK;
+        if (mapped) desc.Set(file, next);
+      }
+      if (!mapped) {
+        policy->frameFreed(extra);
+        desc.latch.unlock();
+        break;
+      }
+      frames[count] = extra;
+      pages[count] = &bufPool[extra];
+      ++count;
+    }
+    read = file.readPages(pageNo, count, pages);
+  } catch (...) {
+    for (std::uint32_t i = 1; i < count; ++i) {
+      abandonFrame(file, pageNo + i, frames[i]);
+      bufDescTable[frames[i]].latch.unlock();
+    }
+    throw;
+  }
+
+  prefetched = 0;
+  for (std::uint32_t i = 1; i < count; ++i) {
+    BufDesc& desc = bufDescTable[frames[i]];
+    if (i < read && pages[i]->isUsed()) {
+      localStats().diskreads++;
+      localStats().prefetched++;
+      ++prefetched;
+      desc.valid.store(true, std::memory_order_release);
+      policy->frameLoaded(frames[i], file.id(), pageNo + i);
+      if (strategy != nullptr)
+        strategy->recordLoad(frames[i], file.id(), pageNo + i);
+      desc.pinCnt--;
+    } else {
+      abandonFrame(file, pageNo + i, frames[i]);
+    }
+    desc.latch.unlock();
+  }
 
-void BufMgr::flushFile(File& file) {}
+  if (read == 0 || !pages[0]->isUsed()) return Status::INVALID_PAGE;
+  return Status::OK;
+}
+
+std::uint32_t BufMgr::prefetchPages(File& file, const PageId* pageNos,
+                                    const std::uint32_t count) {
+  std::vector<FrameId> frames;
+  std::vector<PageId> framePages;
+  std::vector<int> errors;
+  try {
+    const PageId endPage = file.readHeader().num_pages;
+    // Map a latched frame to each page, as for a miss.
+    for (std::uint32_t i = 0; i < count; ++i) {
+      const PageId pageNo = pageNos[i];
+      if (pageNo == Page::INVALID_NUMBER || pageNo >= endPage) continue;
+      FrameId frame;
+      if (allocBuf(frame, nullptr) != Status::OK) break;
+      BufDesc& desc = bufDescTable[frame];
+      bool mapped;
+      {
+        std::lock_guard<std::mutex> partition(
+            hashTable.partitionLatch(file, pageNo));
+        mapped = hashTable.tryInsert(file, pageNo, frame) == Status::OK;
+        if (mapped) desc.Set(file, pageNo);
+      }
+      if (!mapped) {
+        // Already in the pool (or asked for twice).
+        policy->frameFreed(frame);
+        desc.latch.unlock();
+        continue;
+      }
+      frames.push_back(frame);
+      framePages.push_back(pageNo);
+    }
+
+    errors.resize(frames.size());
+    if (ioEngine->type() == IOEngineType::SYNC) {
+      readFramesSorted(file, frames, framePages, errors);
+    } else {
+      std::lock_guard<std::mutex> engineGuard(ioEngineLatch);
+      for (std::size_t i = 0; i < frames.size(); ++i) {
+        file.readPageAsync(*ioEngine, framePages[i], bufPool[frames[i]],
+                           [&errors, i](int error) { errors[i] = error; });
+      }
+      ioEngine->wait();
+    }
+  } catch (...) {
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+      abandonFrame(file, framePages[i], frames[i]);
+      bufDescTable[frames[i]].latch.unlock();
+    }
+    throw;
+  }
+
+  std::uint32_t loaded = 0;
+  for (std::size_t i = 0; i < frames.size(); ++i) {
+    BufDesc& desc = bufDescTable[frames[i]];
+    if (errors[i] == 0 && bufPool[frames[i]].isUsed()) {
+      localStats().diskreads++;
+      localStats().prefetched++;
+      ++loaded;
+      desc.valid.store(true, std::memory_order_release);
+      policy->frameLoaded(frames[i], file.id(), framePages[i]);
+      desc.pinCnt--;
+    } else {
+      abandonFrame(file, framePages[i], frames[i]);
+    }
+    desc.latch.unlock();
+  }
+  return loaded;
+}
+
+void BufMgr::readFramesSorted(File& file, const std::vector<FrameId>& frames,
+                              const std::vector<PageId>& framePages,
+                              std::vector<int>& errors) {
+  std::vector<std::size_t> order(frames.size());
+  for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+    return framePages[a] < framePages[b];
+  });
+  std::vector<PageId> pageNos(order.size());
+  std::vector<Page*> pages(order.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    pageNos[i] = framePages[order[i]];
+    pages[i] = &bufPool[frames[order[i]]];
+  }
+  try {
+    file.readPages(pageNos.data(), pageNos.size(), pages.data());
+  } catch (const FileIOException& e) {
+    // Which run failed is not known; give up on them all.
+    std::fill(errors.begin(), errors.end(), e.error());
+  }
+}
+
+void BufMgr::unPinPage(File& file, const PageId pageNo, const bool dirty) {
+  std::lock_guard<std::mutex> partition(hashTable.partitionLatch(file, pageNo));
+  FrameId frame;
+  if (hashTable.tryLookup(file, pageNo, frame) != Status::OK) return;
+
+  BufDesc& desc = bufDescTable[frame];
+  // Mark dirty before dropping the pin so an evictor never sees the frame
+  // unpinned but clean.
+  if (dirty) desc.dirty = true;
+  int pins = desc.pinCnt;
+  do {
+    if (pins <= 0) throw PageNotPinnedException(file.filename(), pageNo, frame);
+  } while (!desc.pinCnt.compare_exchange_weak(pins, pins - 1));
+}
+
+void BufMgr::allocPage(File& file, PageId& pageNo, Page*& page,
+                       BufAccessStrategy* strategy) {
+  const FrameId frame = allocFrame(file, strategy);
+  pageNo = bufPool[frame].page_number();
+  page = &bufPool[frame];
+}
 
-void BufMgr::disposePage(File& file, const PageId PageNo) {}
+PinnedPage BufMgr::allocPage(File& file, BufAccessStrategy* strategy) {
+  return PinnedPage(this, allocFrame(file, strategy));
+}
+
+FrameId BufMgr::allocFrame(File& file, BufAccessStrategy* strategy) {
+  localStats().accesses++;
+
+  FrameId frame;
+  if (allocBuf(frame, strategy) != Status::OK) throw BufferExceededException();
+  BufDesc& desc = bufDescTable[frame];
+  std::unique_lock<std::mutex> frameLatch(desc.latch, std::adopt_lock);
+
+  try {
+    bufPool[frame] = file.allocatePage();
+  } catch (...) {
+    policy->frameFreed(frame);
+    throw;
+  }
+  const PageId pageNo = bufPool[frame].page_number();
+  {
+    std::lock_guard<std::mutex> partition(
+        hashTable.partitionLatch(file, pageNo));
+    try {
+      hashTable.insert(file, pageNo, frame);
+    } catch (...) {
+      // Free the frame, whose latch frameLatch drops on the way out, and give
+      // the page back so that it is not left allocated but unreachable.
+      policy->frameFreed(frame);
+      try {
+        file.deletePage(pageNo);
+      } catch (...) {
+      }
+      throw;
+    }
+    desc.Set(file, pageNo);
+  }
+  desc.valid.store(true, std::memory_order_release);
+  policy->frameLoaded(frame, file.id(), pageNo);
+  if (strategy != nullptr) strategy->recordLoad(frame, file.id(), pageNo);
+  return frame;
+}
+
+void BufMgr::unPinFrame(const FrameId frame, const bool dirty) {
+  BufDesc& desc = bufDescTable[frame];
+  // As in unPinPage(), the dirty bit is set before the pin is dropped.  No
+  // partition latch is needed: dropping a pin never makes a page harder to
+  // evict.
+  if (dirty) desc.dirty = true;
+  desc.pinCnt--;
+}
+
+void BufMgr::flushFile(File& file) {
+  // Latch all frames of the file, in frame order so that concurrent flushes
+  // cannot deadlock, and check that none is pinned before writing anything.
+  std::vector<FrameId> frames;
+  std::vector<std::unique_lock<std::mutex>> frameLatches;
+  for (FrameId i = 0; i < numBufs; i++) {
+    BufDesc& desc = bufDescTable[i];
+    std::unique_lock<std::mutex> frameLatch(desc.latch);
+    if (desc.fileId != file.id()) continue;
+
+    if (!desc.valid)
+      throw BadBufferException(i, desc.dirty, desc.valid, false /* refbit */);
+    if (desc.pinCnt > 0)
+      throw PagePinnedException(file.filename(), desc.pageNo, i);
+    frames.push_back(i);
+    frameLatches.push_back(std::move(frameLatch));
+  }
+
+  // Write the dirty pages in page order, so that runs of adjacent pages go
+  // out in one write each.
+  std::vector<FrameId> dirtyFrames;
+  for (FrameId i : frames) {
+    if (bufDescTable[i].dirty.exchange(false)) dirtyFrames.push_back(i);
+  }
+  std::sort(dirtyFrames.begin(), dirtyFrames.end(),
+            [this](FrameId lhs, FrameId rhs) {
+              return bufDescTable[lhs].pageNo < bufDescTable[rhs].pageNo;
+            });
+  std::vector<const Page*> pages;
+  pages.reserve(dirtyFrames.size());
+  for (FrameId i : dirtyFrames) pages.push_back(&bufPool[i]);
+  try {
+    std::lock_guard<std::mutex> engineGuard(ioEngineLatch);
+    file.writePages(pages.data(), pages.size(), ioEngine.get());
+  } catch (...) {
+    for (FrameId i : dirtyFrames) bufDescTable[i].dirty = true;
+    throw;
+  }
+  file.sync();
+  localStats().diskwrites += dirtyFrames.size();
+
+  for (FrameId i : frames) {
+    BufDesc& desc = bufDescTable[i];
+    std::lock_guard<std::mutex> partition(
+        hashTable.partitionLatch(file, desc.pageNo));
+    if (desc.pinCnt > 0)
+      throw PagePinnedException(file.filename(), desc.pageNo, i);
+    if (desc.dirty) continue;  // re-dirtied by a concurrent pin; keep it
+    hashTable.remove(file, desc.pageNo);
+    desc.clear();
+    policy->frameFreed(i);
+  }
+}
+
+void BufMgr::disposePage(File& file, const PageId PageNo) {
+  FrameId frame;
+  bool present;
+  {
+    std::lock_guard<std::mutex> partition(
+        hashTable.partitionLatch(file, PageNo));
+    present = hashTable.tryLookup(file, PageNo, frame) == Status::OK;
+  }
+
+  if (present) {
+    BufDesc& desc = bufDescTable[frame];
+    std::lock_guard<std::mutex> frameLatch(desc.latch);
+    std::lock_guard<std::mutex> partition(
+        hashTable.partitionLatch(file, PageNo));
+    // The frame may have been evicted between the lookup and the latch.
+    if (desc.valid && desc.fileId == file.id() && desc.pageNo == PageNo) {
+      if (desc.pinCnt > 0)
+        throw PagePinnedException(file.filename(), PageNo, frame);
+      hashTable.remove(file, PageNo);
+      desc.clear();
+      policy->frameFreed(frame);
+    }
+  }
+
+  file.deletePage(PageNo);
+}
+
+BufStatsStripe& BufMgr::localStats() {
+  static std::atomic<unsigned> nextStripe(0);
+  thread_local const unsigned stripe = nextStripe++ % NUM_STAT_STRIPES;
+  return bufStats[stripe];
+}
+
+BufStats BufMgr::getBufStats() const {
+  BufStats stats;
+  for (const BufStatsStripe& stripe : bufStats) {
+    stats.accesses += stripe.accesses;
+    stats.diskreads += stripe.diskreads;
+    stats.diskwrites += stripe.diskwrites;
+    stats.prefetched += stripe.prefetched;
+    stats.evictwrites += stripe.evictwrites;
+    stats.bgwrites += stripe.bgwrites;
+  }
+  return stats;
+}
+
+void BufMgr::clearBufStats() {
+  for (BufStatsStripe& stripe : bufStats) stripe.clear();
+  policy->clearStats();
+}
 
 void BufMgr::printSelf(void) {
   int validFrames = 0;
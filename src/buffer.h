@@ -8,11 +8,21 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "bufHashTbl.h"
 #include "file.h"
+#include "io_engine.h"
+#include "replacement_policy.h"
 
 namespace badgerdb {
 
@@ -23,6 +33,11 @@ class BufMgr;
 
 /**
  * @brief Class for maintaining information about buffer pool frames
+ *
+ * The identity of a frame (fileId, pageNo, valid) only changes while its latch
+ * is held, and only while the frame is unpinned and not reachable through the
+ * hash table.  pinCnt, dirty and valid are atomic so that read hits and
+ * unpins never need the latch.
  */
 class BufDesc {
  public:
@@ -34,9 +49,16 @@ class BufDesc {
  private:
   friend class BufMgr;
   /**
-   * Pointer to file to which corresponding frame is assigned
+   * Id of file to which corresponding frame is assigned
    */
-  File file;
+  FileId fileId;
+
+  /**
+   * State of that file, through which the frame writes its page back.  Held
+   * directly rather than as a File object so that assigning and clearing
+   * frames does not go through the registry of open files.
+   */
+  std::shared_ptr<File::OpenFile> openFile;
 
   /**
    * Page within file to which corresponding frame is assigned
@@ -51,32 +73,34 @@ class BufDesc {
   /**
    * Number of times this page has been pinned
    */
-  int pinCnt;
+  std::atomic<int> pinCnt;
 
   /**
    * True if page is dirty;  false otherwise
    */
-  bool dirty;
+  std::atomic<bool> dirty;
 
   /**
-   * True if page is valid
+   * True if page is valid.  Set (with release semantics) only once the page
+   * contents have been read into the frame.
    */
-  bool valid;
+  std::atomic<bool> valid;
 
   /**
-   * Has this buffer frame been reference recently
+   * Latch held while the frame changes identity or its page is being read or
+   * written back.
    */
-  bool refbit;
+  std::mutex latch;
 
   /**
    * Initialize buffer frame for a new user
    */
   void clear() {
     pinCnt = 0;
-    file = File();
+    fileId = File::INVALID_ID;
+    openFile.reset();
     pageNo = Page::INVALID_NUMBER;
     dirty = false;
-    refbit = false;
     valid = false;
   }
 
@@ -85,29 +109,30 @@ class BufDesc {
    * page in the file. Called when a frame in buffer pool is allocated to any
    * page in the file through readPage() or allocPage()
    *
-   * @param filePtr	File object
+   * The frame is left invalid; the caller marks it valid once the page
+   * contents are in place.
+   *
+   * @param file   	File object
    * @param pageNum	Page number in the file
    */
   void Set(File& file, PageId pageNum) {
-    this->file = file;
+    fileId = file.id();
+    openFile = file.open_file_;
     pageNo = pageNum;
     pinCnt = 1;
     dirty = false;
-    valid = true;
-    refbit = true;
   }
 
   void Print() {
-    if (file.isValid()) {
-      std::cout << "file:" << file.filename() << " ";
+    if (openFile) {
+      std::cout << "file:" << openFile->filename << " ";
       std::cout << "pageNo:" << pageNo << " ";
     } else
       std::cout << "file:NULL ";
 
     std::cout << "valid:" << valid << " ";
     std::cout << "pinCnt:" << pinCnt << " ";
-    std::cout << "dirty:" << dirty << " ";
-    std::cout << "refbit:" << refbit << "\n";
+    std::cout << "dirty:" << dirty << "\n";
   }
 };
 
@@ -121,7 +146,7 @@ struct BufStats {
   int accesses;
 
   /**
-   * Number of pages read from disk (including allocs)
+   * Number of pages read from disk
    */
   int diskreads;
 
@@ -130,10 +155,30 @@ struct BufStats {
    */
   int diskwrites;
 
+  /**
+   * Number of pages read ahead of a request or by prefetchPages() (included
+   * in diskreads)
+   */
+  int prefetched;
+
+  /**
+   * Number of dirty victims a caller had to write back before it could reuse
+   * their frame (included in diskwrites)
+   */
+  int evictwrites;
+
+  /**
+   * Number of pages written back by the background writer (included in
+   * diskwrites)
+   */
+  int bgwrites;
+
   /**
    * Clear all values
    */
-  void clear() { accesses = diskreads = diskwrites = 0; }
+  void clear() {
+    accesses = diskreads = diskwrites = prefetched = evictwrites = bgwrites = 0;
+  }
 
   /**
    * Constructor of BufStats class
@@ -141,16 +186,206 @@ struct BufStats {
   BufStats() { clear(); }
 };
 
+/**
+ * @brief One stripe of the buffer pool usage counters.
+ *
+ * Threads update the stripe picked by their thread id, so that counting
+ * accesses on read hits does not bounce a single cache line between cores.
+ * Aligned to a cache line for the same reason.
+ */
+struct alignas(64) BufStatsStripe {
+  std::atomic<int> accesses;
+  std::atomic<int> diskreads;
+  std::atomic<int> diskwrites;
+  std::atomic<int> prefetched;
+  std::atomic<int> evictwrites;
+  std::atomic<int> bgwrites;
+
+  /**
+   * Clear all values
+   */
+  void clear() {
+    accesses = diskreads = diskwrites = prefetched = evictwrites = bgwrites = 0;
+  }
+
+  BufStatsStripe() { clear(); }
+};
+
+/**
+ * @brief Ring of frames recycled by one sequential scan or bulk load.
+ *
+ * Pages that miss in the buffer pool while being read or allocated through a
+ * strategy are placed in the frames of a small ring: once the ring is full,
+ * the next such page reuses the frame of the oldest one, if nobody has it
+ * pinned, instead of asking the replacement policy for a victim.  A one-off
+ * scan thus occupies at most ringSize() frames and cannot push the working
+ * set of other callers out of the pool.  Pages that hit are used in place and
+ * not added to the ring.  Dirty ring pages are written back when their frame
+ * is recycled, so a bulk load pays for its own writes.
+ *
+ * A strategy belongs to a single caller and must not be shared between
+ * threads.  It should be a small fraction of the buffer pool; the default is
+ * 32 frames.
+ */
+class BufAccessStrategy {
+  friend class BufMgr;
+
+ public:
+  /**
+   * Default number of frames in the ring
+   */
+  static const std::uint32_t DEFAULT_RING_SIZE = 32;
+
+  /**
+   * Constructor of BufAccessStrategy class
+   *
+   * @param ringSize  Number of frames in the ring (at least 1)
+   */
+  explicit BufAccessStrategy(std::uint32_t ringSize = DEFAULT_RING_SIZE);
+
+  /**
+   * Returns the number of frames in the ring
+   */
+  std::uint32_t ringSize() const { return ring.size(); }
+
+  /**
+   * Returns how many pages were placed in a recycled ring frame
+   */
+  std::uint64_t getRingReuses() const { return ringReuses; }
+
+ private:
+  /**
+   * A ring frame and the page the strategy last placed in it.  The frame may
+   * since have been evicted and reused by someone else, so it is only
+   * recycled if it still holds that page.
+   */
+  struct Slot {
+    FrameId frameNo;
+    FileId fileId;
+    PageId pageNo;
+  };
+
+  /**
+   * Records that the page that missed last was placed in frame, and advances
+   * to the next slot.
+   */
+  void recordLoad(FrameId frame, FileId fileId, PageId pageNo);
+
+  /**
+   * Slots of the ring; an unused slot has pageNo Page::INVALID_NUMBER
+   */
+  std::vector<Slot> ring;
+
+  /**
+   * Slot the next page that misses goes into
+   */
+  std::uint32_t current;
+
+  /**
+   * Number of pages placed in a recycled ring frame
+   */
+  std::uint64_t ringReuses;
+};
+
+/**
+ * @brief Move-only handle to a page pinned in the buffer pool.
+ *
+ * Returned by the BufMgr::readPage() and BufMgr::allocPage() overloads that
+ * take no Page pointer.  The handle knows the frame its page is in, so
+ * releasing it unpins the frame directly, without the hash table lookup
+ * unPinPage() does.  It is released when it goes out of scope, also by an
+ * exception, and unpins the page as dirty if markDirty() was called.  It must
+ * not outlive its BufMgr.
+ */
+class PinnedPage {
+ public:
+  /**
+   * Creates an empty handle
+   */
+  PinnedPage() : bufMgr(nullptr), frame(0), dirty(false) {}
+
+  PinnedPage(PinnedPage&& other) noexcept;
+
+  PinnedPage& operator=(PinnedPage&& other) noexcept;
+
+  PinnedPage(const PinnedPage&) = delete;
+
+  PinnedPage& operator=(const PinnedPage&) = delete;
+
+  /**
+   * Unpins the page, if the handle still holds it
+   */
+  ~PinnedPage() { release(); }
+
+  /**
+   * Returns the pinned page, or nullptr for an empty handle
+   */
+  Page* get() const;
+
+  Page& operator*() const { return *get(); }
+
+  Page* operator->() const { return get(); }
+
+  /**
+   * Returns whether the handle holds a page
+   */
+  explicit operator bool() const { return bufMgr != nullptr; }
+
+  /**
+   * Returns the frame the page is pinned in
+   */
+  FrameId frameNumber() const { return frame; }
+
+  /**
+   * Records that the page was modified; it is unpinned as dirty.
+   */
+  void markDirty() { dirty = true; }
+
+  /**
+   * Unpins the page now and empties the handle.  Does nothing if it is
+   * empty.
+   */
+  void release();
+
+ private:
+  friend class BufMgr;
+
+  PinnedPage(BufMgr* bufMgr, FrameId frame)
+      : bufMgr(bufMgr), frame(frame), dirty(false) {}
+
+  /**
+   * Buffer manager the page is pinned in, nullptr if the handle is empty
+   */
+  BufMgr* bufMgr;
+
+  /**
+   * Frame holding the page
+   */
+  FrameId frame;
+
+  /**
+   * Whether to unpin the page as dirty
+   */
+  bool dirty;
+};
+
 /**
  * @brief The central class which manages the buffer pool including frame
  * allocation and deallocation to pages in the file
+ *
+ * All public methods may be called concurrently from multiple threads.  Read
+ * hits only take the latch of one hash table partition; misses additionally
+ * latch the victim frame, and no latch other than the frame's own is held
+ * while a page is read or written back.
  */
 class BufMgr {
+  friend class PinnedPage;
+
  private:
   /**
-   * Current position of clockhand in our buffer pool
+   * Number of stripes the usage statistics are spread over.
    */
-  FrameId clockHand;
+  static const int NUM_STAT_STRIPES = 16;
 
   /**
    * Number of frames in the buffer pool
@@ -171,33 +406,298 @@ class BufMgr {
   /**
    * Maintains Buffer pool usage statistics
    */
-  BufStats bufStats;
+  BufStatsStripe bufStats[NUM_STAT_STRIPES];
+
+  /**
+   * Replacement policy choosing the frames allocBuf() reuses
+   */
+  std::unique_ptr<ReplacementPolicy> policy;
+
+  /**
+   * Size of the first read-ahead window of a sequential run, in pages
+   */
+  static const std::uint32_t READ_AHEAD_MIN = 4;
+
+  /**
+   * Largest read-ahead window, in pages
+   */
+  static const std::uint32_t READ_AHEAD_MAX = 32;
+
+  /**
+   * @brief Sequential access detection for one file.
+   */
+  struct ReadAheadState {
+    /**
+     * Page a sequential reader is expected to miss on next
+     */
+    PageId nextPage;
+
+    /**
+     * Read-ahead window used on the last miss; 0 if it was not sequential
+     */
+    std::uint32_t window;
+  };
+
+  /**
+   * Largest read-ahead window currently allowed, 0 if read-ahead is off
+   */
+  std::atomic<std::uint32_t> maxReadAhead;
+
+  /**
+   * Protects readAheadStates.  Only taken on misses.
+   */
+  std::mutex readAheadLatch;
+
+  /**
+   * Access pattern of every file read through the buffer pool, by file id
+   */
+  std::unordered_map<FileId, ReadAheadState> readAheadStates;
 
   /**
-   * Advance clock to next frame in the buffer pool
+   * Background writer thread, if started
    */
-  void advanceClock();
+  std::thread bgWriter;
 
   /**
-   * Allocate a free frame.
+   * Whether the background writer is running
+   */
+  std::atomic<bool> bgWriterRunning;
+
+  /**
+   * Protects the background writer's settings and flags below
+   */
+  std::mutex bgWriterLatch;
+
+  /**
+   * Signalled to wake the background writer up early
+   */
+  std::condition_variable bgWriterWake;
+
+  /**
+   * Asks the background writer to exit
+   */
+  bool bgWriterStop;
+
+  /**
+   * Set when a caller had to write back a victim itself
+   */
+  bool bgWriterKicked;
+
+  /**
+   * Number of next victims the background writer keeps clean
+   */
+  std::uint32_t bgWriterTarget;
+
+  /**
+   * Time the background writer sleeps between rounds
+   */
+  std::chrono::milliseconds bgWriterInterval;
+
+  /**
+   * Engine issuing batches of reads and writes together; io_uring when the
+   * kernel provides it
+   */
+  std::unique_ptr<IOEngine> ioEngine;
+
+  /**
+   * Serializes use of ioEngine
+   */
+  std::mutex ioEngineLatch;
+
+  /**
+   * Allocate a free frame: the next frame of the strategy's ring if it can be
+   * recycled, otherwise one chosen by the replacement policy.  The frame is
+   * returned with its latch held, unpinned
+   * and invalid, and no longer reachable through the hash table; a dirty
+   * victim has already been written back.
    *
    * @param frame   	Frame reference, frame ID of allocated frame returned
    * via this variable
-   * @throws BufferExceededException If no such buffer is found which can be
-   * allocated
+   * @param strategy  Access strategy of the caller, or nullptr
+   * @return  Status::BUFFER_EXCEEDED if no such buffer is found which can be
+   * allocated, Status::OK otherwise.
+   */
+  Status allocBuf(FrameId& frame, BufAccessStrategy* strategy);
+
+  /**
+   * Latches the given frame if it is unpinned and its latch is free.
+   *
+   * @return  True if the frame is now latched by the caller.
+   */
+  bool tryClaimFrame(const FrameId frame);
+
+  /**
+   * Writes back the page in a claimed frame if it is dirty and removes it from
+   * the hash table.  Does nothing if the frame holds no page.
+   *
+   * @param frame   Frame latched by the caller
+   * @return  False if the page was pinned or dirtied again meanwhile; it then
+   * stays in the frame.
+   */
+  bool evictPage(const FrameId frame);
+
+  /**
+   * Claims the next frame of the strategy's ring if it still holds the page
+   * the strategy put there and is not pinned, and evicts that page.
+   *
+   * @param strategy  Access strategy of the caller
+   * @param frame   Set to the claimed frame, whose latch is held on return
+   * @return  True if a frame was claimed.
+   */
+  bool claimRingFrame(BufAccessStrategy& strategy, FrameId& frame);
+
+  /**
+   * Reads (file, pageNo) into the pool if needed and pins it; the body of
+   * both readPage() variants.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file to be read
+   * @param strategy  Access strategy, or nullptr (see readPage())
+   * @param frame   Set to the frame the page is pinned in, on success
+   * @return  Status::INVALID_PAGE if the page doesn't exist in the file,
+   * Status::BUFFER_EXCEEDED if every frame is pinned, Status::OK otherwise.
+   */
+  Status fetchPage(File& file, const PageId pageNo,
+                   BufAccessStrategy* strategy, FrameId& frame);
+
+  /**
+   * Allocates a page in the file and pins it in a frame; the body of both
+   * allocPage() variants.
+   *
+   * @param file   	File object
+   * @param strategy  Access strategy, or nullptr (see allocPage())
+   * @return  The frame the new page is pinned in.
+   * @throws BufferExceededException If every frame in the pool is pinned
+   */
+  FrameId allocFrame(File& file, BufAccessStrategy* strategy);
+
+  /**
+   * Drops one pin of a frame pinned through a PinnedPage.
+   *
+   * @param frame   Frame to unpin
+   * @param dirty   True if the page needs to be marked dirty
+   */
+  void unPinFrame(const FrameId frame, const bool dirty);
+
+  /**
+   * Wakes the background writer up, if it is running, after a caller had to
+   * write back a victim.
+   */
+  void kickBackgroundWriter();
+
+  /**
+   * Body of the background writer thread.
+   */
+  void backgroundWriterLoop();
+
+  /**
+   * One round of the background writer: writes back the dirty, unpinned pages
+   * among the next target frames the replacement policy would evict, sorted by
+   * file and page number.
+   *
+   * @param target  Number of next evictable frames to keep clean
+   * @return  Number of pages written
+   */
+  std::uint32_t cleanAhead(const std::uint32_t target);
+
+  /**
+   * Returns how many pages to read ahead of a miss on (file, pageNo): 0 unless
+   * the file's recent misses form a sequential run, otherwise a window that
+   * doubles with every further miss of the run up to maxReadAhead.  Kept
+   * within half the ring of the caller's strategy, if any.
+   */
+  std::uint32_t readAheadWindow(const File& file, const PageId pageNo,
+                                const BufAccessStrategy* strategy);
+
+  /**
+   * Records a miss on (file, pageNo) that read ahead prefetched pages, using
+   * the given window, for sequential access detection.
+   */
+  void recordMiss(const File& file, const PageId pageNo,
+                  const std::uint32_t window, const std::uint32_t prefetched);
+
+  /**
+   * Reads the page pageNo into frame together with up to readAhead following
+   * pages, in a single read.  Read-ahead stops at the end of the file, at the
+   * first following page already in the pool and when no frame can be had.
+   * Prefetched pages are left valid and unpinned.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number requested
+   * @param frame   Frame mapped to pageNo, latched by the caller
+   * @param readAhead  Maximum number of pages to read ahead
+   * @param strategy  Access strategy of the caller, or nullptr
+   * @param prefetched  Set to the number of pages read ahead
+   * @return  Status::INVALID_PAGE if pageNo is not a used page of the file,
+   * Status::OK otherwise.
+   */
+  Status readWithReadAhead(File& file, const PageId pageNo,
+                           const FrameId frame, const std::uint32_t readAhead,
+                           BufAccessStrategy* strategy,
+                           std::uint32_t& prefetched);
+
+  /**
+   * Gives up a frame whose page could not be read in: removes its hash table
+   * entry and drops the reader's pin.  Called with the frame latch held.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number the frame was being loaded with
+   * @param frame   Frame to give up
+   */
+  void abandonFrame(File& file, const PageId pageNo, const FrameId frame);
+
+  /**
+   * Reads pages into latched frames in page order, one vectored read per run
+   * of adjacent pages.  If a read fails, every frame is marked failed.
+   *
+   * @param file   	    File object
+   * @param frames      Frames to read into
+   * @param framePages  Page to read into each frame
+   * @param errors      Set to the errno value of each failed read
+   */
+  void readFramesSorted(File& file, const std::vector<FrameId>& frames,
+                        const std::vector<PageId>& framePages,
+                        std::vector<int>& errors);
+
+  /**
+   * Pins the frame holding (file, pageNo) if it is in the buffer pool.  Waits
+   * for the page contents if another thread is still reading them in.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   * @param frame   Frame reference, frame holding the page returned via this
+   * variable
+   * @return  True if the page was found and pinned.
    */
-  void allocBuf(FrameId& frame);
+  bool pinIfPresent(File& file, const PageId pageNo, FrameId& frame);
+
+  /**
+   * Returns the statistics stripe for the calling thread.
+   */
+  BufStatsStripe& localStats();
 
  public:
   /**
-   * Actual buffer pool from which frames are allocated
+   * Actual buffer pool from which frames are allocated: one contiguous,
+   * page-aligned block, each frame exactly one page as on disk
    */
   std::vector<Page> bufPool;
 
   /**
    * Constructor of BufMgr class
+   *
+   * @param bufs        Number of frames in the buffer pool
+   * @param policyType  Replacement policy used to choose frames to reuse
    */
-  BufMgr(std::uint32_t bufs);
+  BufMgr(std::uint32_t bufs,
+         ReplacementPolicyType policyType = ReplacementPolicyType::CLOCK);
+
+  /**
+   * Flushes out all dirty pages and deallocates the buffer pool.  Pages that
+   * cannot be written, because they were deleted from their file or the
+   * write failed, are dropped.
+   */
+  ~BufMgr();
 
   /**
    * Reads the given page from the file into a frame and returns the pointer to
@@ -209,8 +709,40 @@ class BufMgr {
    * @param PageNo  Page number in the file to be read
    * @param page  	Reference to page pointer. Used to fetch the Page object
    * in which requested page from file is read in.
+   * @param strategy  Access strategy for a sequential scan, whose ring the
+   * page is read into on a miss; nullptr for normal access.
+   * @throws InvalidPageException If the page doesn't exist in the file
+   * @throws BufferExceededException If every frame in the pool is pinned
+   */
+  void readPage(File& file, const PageId pageNo, Page*& page,
+                BufAccessStrategy* strategy = nullptr);
+
+  /**
+   * Non-throwing variant of readPage().
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer, only set on success.
+   * @param strategy  Access strategy, or nullptr (see readPage())
+   * @return  Status::INVALID_PAGE if the page doesn't exist in the file,
+   * Status::BUFFER_EXCEEDED if every frame is pinned, Status::OK otherwise.
+   */
+  Status tryReadPage(File& file, const PageId pageNo, Page*& page,
+                     BufAccessStrategy* strategy = nullptr);
+
+  /**
+   * Reads the given page as readPage() above does, and returns a handle that
+   * unpins it when released.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param strategy  Access strategy, or nullptr (see readPage() above)
+   * @return  Handle holding the pinned page.
+   * @throws InvalidPageException If the page doesn't exist in the file
+   * @throws BufferExceededException If every frame in the pool is pinned
    */
-  void readPage(File& file, const PageId pageNo, Page*& page);
+  PinnedPage readPage(File& file, const PageId pageNo,
+                      BufAccessStrategy* strategy = nullptr);
 
   /**
    * Unpin a page from memory since it is no longer required for it to remain in
@@ -233,11 +765,51 @@ class BufMgr {
    * returned via this reference.
    * @param page  	Reference to page pointer. The newly allocated in-memory
    * Page object is returned via this reference.
+   * @param strategy  Access strategy for a bulk load, whose ring the page is
+   * placed in; nullptr for normal access.
    */
-  void allocPage(File& file, PageId& pageNo, Page*& page);
+  void allocPage(File& file, PageId& pageNo, Page*& page,
+                 BufAccessStrategy* strategy = nullptr);
 
   /**
-   * Writes out all dirty pages of the file to disk.
+   * Allocates a new page as allocPage() above does, and returns a handle that
+   * unpins it when released.  The page number is that of the returned page.
+   *
+   * @param file   	File object
+   * @param strategy  Access strategy, or nullptr (see allocPage() above)
+   * @return  Handle holding the pinned new page.
+   * @throws BufferExceededException If every frame in the pool is pinned
+   */
+  PinnedPage allocPage(File& file, BufAccessStrategy* strategy = nullptr);
+
+  /**
+   * Loads the given pages of the file into the buffer pool, unpinned, with
+   * all their reads in flight at once.  Meant for callers that know which
+   * scattered pages they will read next, e.g. from an index.  Without an
+   * asynchronous IOEngine, the pages are read in page order with one vectored
+   * read per run of adjacent pages (File::readPages()).  Pages already
+   * in the pool, free pages and pages past the end of the file are skipped,
+   * and so are pages whose read fails; reading them later reports the error.
+   *
+   * @param file   	File object
+   * @param pageNos  Numbers of the pages to load
+   * @param count    Number of pages
+   * @return  Number of pages loaded; fewer than asked for if frames ran out
+   */
+  std::uint32_t prefetchPages(File& file, const PageId* pageNos,
+                              std::uint32_t count);
+
+  /**
+   * Returns the kind of engine prefetchPages() and flushFile() issue their
+   * batches on
+   */
+  IOEngineType getIOEngineType() const { return ioEngine->type(); }
+
+  /**
+   * Writes out all dirty pages of the file to disk, sorted by page number and
+   * with each run of adjacent pages in a single write, all of them in flight
+   * at once, then syncs the file as its SyncPolicy asks (see File::sync()),
+   * and removes the file's pages from the buffer pool.
    * All the frames assigned to the file need to be unpinned from buffer pool
    * before this function can be successfully called. Otherwise Error returned.
    *
@@ -265,14 +837,61 @@ class BufMgr {
   void printSelf();
 
   /**
-   * Get buffer pool usage statistics
+   * Get buffer pool usage statistics.  Returns a copy rather than a reference
+   * to the live counters, so changing it does not affect the buffer manager;
+   * use clearBufStats() to reset them.
+   *
+   * @return  Snapshot of the statistics summed over all stripes.
+   */
+  BufStats getBufStats() const;
+
+  /**
+   * Starts a background writer thread that periodically writes back the dirty
+   * pages the replacement policy is about to evict, so that readers seldom
+   * have to write a victim before reusing its frame.  Restarts it if it is
+   * already running.  Not to be called concurrently with
+   * stopBackgroundWriter().
+   *
+   * @param cleanTarget Number of next victims to keep clean; 0 picks an
+   * eighth of the pool
+   * @param interval    Time between rounds.  A reader that has to write a
+   * victim itself wakes the writer up early.
+   */
+  void startBackgroundWriter(
+      std::uint32_t cleanTarget = 0,
+      std::chrono::milliseconds interval = std::chrono::milliseconds(20));
+
+  /**
+   * Stops the background writer, if running, and waits for it to exit.
+   */
+  void stopBackgroundWriter();
+
+  /**
+   * Sets the largest number of pages read ahead when a sequential scan of a
+   * file is detected, at most 32.  0 turns read-ahead off, which is the
+   * default: callers that scan files opt in, with a window small next to the
+   * pool (an eighth of it or less is a good bound).
+   *
+   * @param pages   Largest read-ahead window, in pages
+   */
+  void setMaxReadAhead(std::uint32_t pages) {
+    maxReadAhead = std::min(pages, READ_AHEAD_MAX);
+  }
+
+  /**
+   * Get the replacement policy's own statistics (hit ratio, eviction cost)
+   */
+  ReplacementStats getReplacementStats() const { return policy->getStats(); }
+
+  /**
+   * Returns the name of the replacement policy in use
    */
-  BufStats& getBufStats() { return bufStats; }
+  const char* getReplacementPolicyName() const { return policy->name(); }
 
   /**
-   * Clear buffer pool usage statistics
+   * Clear buffer pool usage statistics, including the replacement policy's
    */
-  void clearBufStats() { bufStats.clear(); }
+  void clearBufStats();
 };
 
 }  // namespace badgerdb
@@ -0,0 +1,49 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "clock_policy.h"
+
+namespace badgerdb {
+
+ClockPolicy::ClockPolicy(std::uint32_t numFrames)
+    : ReplacementPolicy(numFrames),
+      clockHand(numFrames - 1),
+      refbits(numFrames) {
+  for (std::atomic<bool> &refbit : refbits) refbit = false;
+}
+
+FrameId ClockPolicy::advanceClock() { return (++clockHand) % numFrames; }
+
+void ClockPolicy::peekVictims(std::vector<FrameId> &frames,
+                              std::uint32_t count) {
+  // Frames ahead of the hand whose reference bit is already clear are the
+  // ones the next sweep evicts.
+  const FrameId hand = clockHand.load(std::memory_order_relaxed);
+  for (std::uint32_t i = 1; i <= numFrames && frames.size() < count; i++) {
+    const FrameId candidate = (hand + i) % numFrames;
+    if (!refbits[candidate].load(std::memory_order_relaxed))
+      frames.push_back(candidate);
+  }
+}
+
+bool ClockPolicy::chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                               std::uint64_t &examined) {
+  // Two full sweeps: the first one may do nothing but clear reference bits.
+  for (std::uint32_t i = 0; i < 2 * numFrames; i++) {
+    const FrameId candidate = advanceClock();
+    ++examined;
+    if (refbits[candidate].exchange(false)) continue;
+    if (tryClaim(candidate)) {
+      frame = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace badgerdb
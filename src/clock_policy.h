@@ -0,0 +1,71 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Second-chance clock replacement.
+ *
+ * Every access sets the frame's reference bit; the clock hand clears set bits
+ * and evicts the first frame whose bit was already clear.  Latch-free: the
+ * hand is an atomic counter, so concurrent evictions sweep different frames.
+ */
+class ClockPolicy : public ReplacementPolicy {
+ public:
+  explicit ClockPolicy(std::uint32_t numFrames);
+
+  const char *name() const override { return "clock"; }
+
+  void frameFreed(FrameId frame) override { refbits[frame] = false; }
+
+  void frameRestored(FrameId frame) override { refbits[frame] = true; }
+
+  void peekVictims(std::vector<FrameId> &frames, std::uint32_t count) override;
+
+ protected:
+  void onAccess(FrameId frame) override {
+    // Avoid dirtying the cache line when the bit is already set.
+    if (!refbits[frame].load(std::memory_order_relaxed)) refbits[frame] = true;
+  }
+
+  void onLoad(FrameId frame, std::uint64_t pageKey) override {
+    refbits[frame] = true;
+  }
+
+  bool chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                    std::uint64_t &examined) override;
+
+ private:
+  /**
+   * Advance clock to next frame in the buffer pool
+   *
+   * @return  The frame the clock hand now points at.  Concurrent callers
+   * each get a different frame.
+   */
+  FrameId advanceClock();
+
+  /**
+   * Current position of clockhand in our buffer pool.  Only ever advanced;
+   * taken modulo numFrames when used.
+   */
+  std::atomic<FrameId> clockHand;
+
+  /**
+   * Has each frame been referenced recently
+   */
+  std::vector<std::atomic<bool>> refbits;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "file_full_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+FileFullException::FileFullException(const std::string &name)
+    : BadgerDbException(""), filename_(name) {
+  std::stringstream ss;
+  ss << "File has no room for more pages: " << filename_;
+  message_.assign(ss.str());
+}
+
+}  // namespace badgerdb
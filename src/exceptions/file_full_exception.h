@@ -0,0 +1,42 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page is to be allocated in a file
+ *        that has as many pages as it can keep track of.
+ */
+class FileFullException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a file full exception for the given file.
+   *
+   * @param name  Name of file that's full.
+   */
+  explicit FileFullException(const std::string &name);
+
+  /**
+   * Returns the name of the file that caused this exception.
+   */
+  virtual const std::string &filename() const { return filename_; }
+
+ protected:
+  /**
+   * Name of file that caused this exception.
+   */
+  const std::string filename_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,25 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "invalid_page_count_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+InvalidPageCountException::InvalidPageCountException(
+    const PageId requested_count, const std::string &file)
+    : BadgerDbException(""), count_(requested_count), filename_(file) {
+  std::stringstream ss;
+  ss << "Cannot allocate a run of " << count_ << " pages in file: "
+     << filename_;
+  message_.assign(ss.str());
+}
+
+}  // namespace badgerdb
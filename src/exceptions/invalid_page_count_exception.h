@@ -0,0 +1,56 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a run of pages is to be allocated
+ *        that is empty or too long to fit between two directory pages.
+ */
+class InvalidPageCountException : public BadgerDbException {
+ public:
+  /**
+   * Constructs an invalid page count exception for the given requested number
+   * of pages and filename.
+   *
+   * @param requested_count   Requested number of pages.
+   * @param file              Name of file that request was made to.
+   */
+  InvalidPageCountException(const PageId requested_count,
+                            const std::string &file);
+
+  /**
+   * Returns the requested number of pages that caused this exception.
+   */
+  virtual PageId count() const { return count_; }
+
+  /**
+   * Returns name of the file that caused this exception.
+   */
+  virtual const std::string &filename() const { return filename_; }
+
+ protected:
+  /**
+   * Requested number of pages which caused this exception.
+   */
+  const PageId count_;
+
+  /**
+   * Name of file which caused this exception.
+   */
+  const std::string filename_;
+};
+
+}  // namespace badgerdb
@@ -8,31 +8,50 @@
 
 #include "file.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "exceptions/file_exists_exception.h"
+#include "exceptions/file_full_exception.h"
+#include "exceptions/file_io_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
+#include "exceptions/invalid_page_count_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "file_iterator.h"
 #include "page.h"
 
 namespace badgerdb {
 
-File::StreamMap File::open_streams_;
-File::CountMap File::open_counts_;
+const std::uint32_t FileHeader::MAGIC;
+const std::uint32_t FileHeader::VERSION;
+const std::size_t FileHeader::V1_SIZE;
 
-File File::create(const std::string &filename) {
-  return File(filename, true /* create_new */);
+const PageId File::DEFAULT_EXTENT_PAGES;
+const SyncPolicy File::DEFAULT_SYNC_POLICY;
+
+File::OpenFileMap File::open_files_;
+File::IdMap File::file_ids_;
+std::mutex File::open_files_mutex_;
+std::condition_variable File::open_files_closed_;
+
+File File::create(const std::string &filename, const FileBackend backend) {
+  return File(filename, true /* create_new */, backend);
 }
 
-File File::open(const std::string &filename) {
-  return File(filename, false /* create_new */);
+File File::open(const std::string &filename, const FileBackend backend) {
+  return File(filename, false /* create_new */, backend);
 }
 
 void File::remove(const std::string &filename) {
@@ -49,7 +68,8 @@ bool File::isOpen(const std::string &filename) {
   if (!exists(filename)) {
     return false;
   }
-  return open_counts_.find(filename) != open_counts_.end();
+  std::lock_guard<std::mutex> guard(open_files_mutex_);
+  return open_files_.find(filename) != open_files_.end();
 }
 
 bool File::exists(const std::string &filename) {
@@ -64,189 +84,410 @@ bool File::exists(const std::string &filename) {
 
 File::File(const File &other)
     : filename_(other.filename_),
-      stream_(open_streams_[filename_]),
-      valid_(other.valid_) {
-  ++open_counts_[filename_];
-}
+      id_(other.id_),
+      open_file_(other.open_file_),
+      valid_(other.valid_) {}
 
 File &File::operator=(const File &rhs) {
-  // This accounts for self-assignment and assignment of a File object for the
-  // same file.
+  // Taking the new reference first accounts for self-assignment and
+  // assignment of a File object for the same file.
+  std::shared_ptr<OpenFile> open_file = rhs.open_file_;
   close();  // close my file and associate me with the new one
   filename_ = rhs.filename_;
+  id_ = rhs.id_;
   valid_ = rhs.valid_;
-  openIfNeeded(false /* create_new */);
+  open_file_ = std::move(open_file);
   return *this;
 }
 
 File::~File() { close(); }
 
 Page File::allocatePage() {
-  FileHeader header = readHeader();
-  Page new_page;
-  Page existing_page;
-  if (header.num_free_pages > 0) {
-    new_page = readPage(header.first_free_page, true /* allow_free */);
-    new_page.set_page_number(header.first_free_page);
-    header.first_free_page = new_page.next_page_number();
-    --header.num_free_pages;
-
-    if (header.first_used_page == Page::INVALID_NUMBER ||
-        header.first_used_page > new_page.page_number()) {
-      // Either have no pages used or the head of the used list is a page
-      // later than the one we just allocated, so add the new page to the
-      // head.
-      if (header.first_used_page > new_page.page_number()) {
-        new_page.set_next_page_number(header.first_used_page);
-      }
-      header.first_used_page = new_page.page_number();
-    } else {
-      // New page is reused from somewhere after the beginning, so we need
-      // to find where in the used list to insert it.
-      PageId next_page_number = Page::INVALID_NUMBER;
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        next_page_number = (*iter).next_page_number();
-        if (next_page_number > new_page.page_number() ||
-            next_page_number == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
+  std::lock_guard<std::recursive_mutex> guard(open_file_->latch);
+  OpenFile &open_file = *open_file_;
+  if (readHeader().num_free_pages == 0) {
+    extend(1);
+  }
+
+  Page page;
+  std::lock_guard<std::mutex> metadata(open_file.metadata_mutex);
+  FileHeader &header = open_file.header;
+  PageDirectory &directory = open_file.directory;
+  const PageId page_number = directory.findFree(header.num_pages);
+  assert(page_number != Page::INVALID_NUMBER);
+  directory.setUsed(page_number, true);
+  --header.num_free_pages;
+  open_file.header_dirty = true;
+  page.set_page_number(page_number);
+  page.set_next_page_number(directory.nextUsed(page_number, header.num_pages));
+  return page;
+}
+
+PageRun File::allocatePages(const PageId count) {
+  // A longer run could never fit between two directory pages.
+  if (count == 0 || count >= PageDirectory::DIRECTORY_PAGE_BITS) {
+    throw InvalidPageCountException(count, filename_);
+  }
+  std::lock_guard<std::recursive_mutex> guard(open_file_->latch);
+  OpenFile &open_file = *open_file_;
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> metadata(open_file.metadata_mutex);
+      FileHeader &header = open_file.header;
+      PageDirectory &directory = open_file.directory;
+      const PageId first = directory.findFreeRun(count, header.num_pages);
+      if (first != Page::INVALID_NUMBER) {
+        for (PageId page_number = first; page_number < first + count;
+             ++page_number) {
+          directory.setUsed(page_number, true);
         }
+        header.num_free_pages -= count;
+        open_file.header_dirty = true;
+        return PageRun{first, count};
       }
-      existing_page.set_next_page_number(new_page.page_number());
-      new_page.set_next_page_number(next_page_number);
     }
+    // The pages added at the end may be split by a directory page, which
+    // takes a second extension to get past.
+    extend(count);
+  }
+}
 
-    assert((header.num_free_pages == 0) ==
-           (header.first_free_page == Page::INVALID_NUMBER));
-  } else {
-    new_page.set_page_number(header.num_pages);
-    if (header.first_used_page == Page::INVALID_NUMBER) {
-      header.first_used_page = new_page.page_number();
-    } else {
-      // If we have pages allocated, we need to add the new page to the
-      // tail of the linked list.
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
-        if ((*iter).next_page_number() == Page::INVALID_NUMBER) {
-          existing_page = *iter;
-          break;
-        }
+void File::setExtentPages(const PageId pages) {
+  std::lock_guard<std::recursive_mutex> guard(open_file_->latch);
+  open_file_->extent_pages = std::max<PageId>(pages, 1);
+}
+
+PageId File::extentPages() const {
+  std::lock_guard<std::recursive_mutex> guard(open_file_->latch);
+  return open_file_->extent_pages;
+}
+
+void File::extend(const PageId min_free_pages) {
+  OpenFile &open_file = *open_file_;
+  PageId first;
+  PageId free_pages;
+  PageId new_pages = 0;
+  std::vector<PageId> directory_pages;
+  {
+    std::lock_guard<std::mutex> metadata(open_file.metadata_mutex);
+    const PageDirectory &directory = open_file.directory;
+    first = open_file.header.num_pages;
+    // Grow geometrically up to a whole extent, so that small files stay small.
+    free_pages =
+        std::max(min_free_pages, std::min(open_file.extent_pages, first));
+    std::uint64_t capacity = directory.capacity();
+    for (PageId added = 0; added < free_pages; ++new_pages) {
+      if (new_pages == std::numeric_limits<PageId>::max() - first) {
+        // Out of page numbers.
+        throw FileFullException(filename_);
+      }
+      if (first + new_pages == capacity) {
+        directory_pages.push_back(first + new_pages);
+        capacity += PageDirectory::DIRECTORY_PAGE_BITS;
+      } else {
+        ++added;
       }
-      assert(existing_page.isUsed());
-      existing_page.set_next_page_number(new_page.page_number());
     }
-    ++header.num_pages;
   }
-  writePage(new_page.page_number(), new_page);
-  if (existing_page.page_number() != Page::INVALID_NUMBER) {
-    // If we updated an existing page by inserting the new page into the
-    // used list, we need to write it out.
-    writePage(existing_page.page_number(), existing_page);
+
+  // Reserve the space, and write the pages empty so that allocating one
+  // later writes nothing.
+  FileIO &io = *open_file.io;
+  io.allocate(pagePosition(first),
+              static_cast<std::uint64_t>(new_pages) * Page::SIZE);
+  const PageId chunk_pages = std::min(new_pages, DEFAULT_EXTENT_PAGES);
+  const std::vector<Page> empty(chunk_pages);
+  const char *buffer = reinterpret_cast<const char *>(empty.data());
+  for (PageId done = 0; done < new_pages; done += chunk_pages) {
+    const PageId pages = std::min(chunk_pages, new_pages - done);
+    io.write(buffer, pages * Page::SIZE, pagePosition(first + done));
   }
-  writeHeader(header);
 
-  return new_page;
+  std::lock_guard<std::mutex> metadata(open_file.metadata_mutex);
+  for (const PageId page_number : directory_pages) {
+    open_file.directory.addDirectoryPage(page_number);
+  }
+  open_file.header.num_pages += new_pages;
+  open_file.header.num_free_pages += free_pages;
+  open_file.header_dirty = true;
 }
 
 Page File::readPage(const PageId page_number) const {
-  FileHeader header = readHeader();
-  if (page_number >= header.num_pages) {
+  Page page;
+  readPageInto(page_number, page);
+  return page;
+}
+
+void File::readPageInto(const PageId page_number, Page &page) const {
+  if (tryReadPage(page_number, page) != Status::OK) {
     throw InvalidPageException(page_number, filename_);
   }
-  return readPage(page_number, false /* allow_free */);
 }
 
-Page File::readPage(const PageId page_number, const bool allow_free) const {
-  Page page;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char *>(&page.header_), sizeof(page.header_));
-  stream_->read(&page.data_[0], Page::DATA_SIZE);
-  if (!allow_free && !page.isUsed()) {
-    throw InvalidPageException(page_number, filename_);
+Status File::tryReadPage(const PageId page_number, Page &page) const {
+  if (!isPageUsed(page_number)) {
+    return Status::INVALID_PAGE;
+  }
+  Page *const pages[] = {&page};
+  readRun(page_number, 1, pages);
+  // Freed meanwhile.
+  if (!page.isUsed()) {
+    return Status::INVALID_PAGE;
   }
+  return Status::OK;
+}
 
-  return page;
+bool File::isPageUsed(const PageId page_number) const {
+  std::lock_guard<std::mutex> guard(open_file_->metadata_mutex);
+  return page_number < open_file_->header.num_pages &&
+         open_file_->directory.isUsed(page_number);
 }
 
-void File::writePage(const Page &new_page) {
-  PageHeader header = readPageHeader(new_page.page_number());
-  if (header.current_page_number == Page::INVALID_NUMBER) {
+PageId File::readPages(const PageId first, const PageId count,
+                       Page *const *pages) const {
+  const FileHeader header = readHeader();
+  if (first == Page::INVALID_NUMBER || first >= header.num_pages) {
+    return 0;
+  }
+  const PageId read_count = std::min(count, header.num_pages - first);
+  readRun(first, read_count, pages);
+  return read_count;
+}
+
+void File::readPages(const PageId *page_numbers, const std::size_t count,
+                     Page *const *pages) const {
+  const PageId num_pages = readHeader().num_pages;
+  std::size_t start = 0;
+  while (start < count) {
+    const PageId first = page_numbers[start];
+    if (first == Page::INVALID_NUMBER || first >= num_pages) {
+      pages[start++]->initialize();
+      continue;
+    }
+    std::size_t run = 1;
+    while (start + run < count && page_numbers[start + run] == first + run &&
+           first + run < num_pages) {
+      ++run;
+    }
+    readRun(first, run, pages + start);
+    start += run;
+  }
+}
+
+void File::readRun(const PageId first, const std::size_t count,
+                   Page *const *pages) const {
+  // Each page lands in place.  Single pages, the common case, take no heap
+  // allocation.
+  iovec single;
+  std::vector<iovec> many(count > 1 ? count : 0);
+  iovec *const iov = count > 1 ? many.data() : &single;
+  for (std::size_t i = 0; i < count; ++i) {
+    iov[i].iov_base = pages[i];
+    iov[i].iov_len = Page::SIZE;
+  }
+  open_file_->io->readv(iov, static_cast<int>(count), pagePosition(first));
+  for (std::size_t i = 0; i < count; ++i) {
+    applyDirectory(*open_file_, first + static_cast<PageId>(i), *pages[i]);
+  }
+}
+
+void File::writePageFrom(const Page &page) {
+  writePageFrom(*open_file_, page);
+}
+
+void File::writePageFrom(OpenFile &open_file, const Page &page) {
+  const PageId page_number = page.page_number();
+  std::lock_guard<std::recursive_mutex> guard(open_file.latch);
+  bool used;
+  {
+    std::lock_guard<std::mutex> metadata(open_file.metadata_mutex);
+    used = page_number < open_file.header.num_pages &&
+           open_file.directory.isUsed(page_number);
+  }
+  if (!used) {
     // Page has been deleted since it was read.
-    throw InvalidPageException(new_page.page_number(), filename_);
+    throw InvalidPageException(page_number, open_file.filename);
   }
-  // Page on disk may have had its next page pointer updated since it was read;
-  // we don't modify that, but we do keep all the other modifications to the
-  // page header.
-  const PageId next_page_number = header.next_page_number;
-  header = new_page.header_;
-  header.next_page_number = next_page_number;
-  writePage(new_page.page_number(), header, new_page);
+  open_file.io->write(reinterpret_cast<const char *>(&page), Page::SIZE,
+                      pagePosition(page_number));
 }
 
-void File::deletePage(const PageId page_number) {
-  FileHeader header = readHeader();
-  Page existing_page = readPage(page_number);
-  Page previous_page;
-  // If this page is the head of the used list, update the header to point to
-  // the next page in line.
-  if (page_number == header.first_used_page) {
-    header.first_used_page = existing_page.next_page_number();
-  } else {
-    // Walk the used list so we can update the page that points to this one.
-    for (FileIterator iter = begin(); iter != end(); ++iter) {
-      previous_page = *iter;
-      if (previous_page.next_page_number() == existing_page.page_number()) {
-        previous_page.set_next_page_number(existing_page.next_page_number());
-        break;
-      }
+void File::readPageAsync(IOEngine &engine, const PageId page_number,
+                         Page &page, IOEngine::Callback done) const {
+  // The request keeps the file open until it completes.
+  std::shared_ptr<OpenFile> open_file = open_file_;
+  engine.queueRead(*open_file->io, reinterpret_cast<char *>(&page), Page::SIZE,
+                   pagePosition(page_number),
+                   [open_file, page_number, &page, done](int error) {
+                     if (error == 0) {
+                       applyDirectory(*open_file, page_number, page);
+                     }
+                     done(error);
+                   });
+}
+
+PageView File::viewPage(const PageId page_number) const {
+  if (!isPageUsed(page_number)) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  const std::uint64_t position = pagePosition(page_number);
+  std::shared_ptr<const void> owner;
+  const char *data = open_file_->io->view(Page::SIZE, position, owner);
+  if (data == nullptr) {
+    // The backend has no view of its own: read a private copy.
+    std::shared_ptr<AlignedBuffer> buffer(new AlignedBuffer(Page::SIZE));
+    open_file_->io->read(buffer->data(), Page::SIZE, position);
+    data = buffer->data();
+    owner = buffer;
+  }
+  if (!reinterpret_cast<const PageHeader *>(data)->current_format) {
+    // A version 1 page, which has to be converted in a copy of its own.
+    std::shared_ptr<Page> page(new Page());
+    std::memcpy(page.get(), data, Page::SIZE);
+    page->convertFromVersion1();
+    data = reinterpret_cast<const char *>(page.get());
+    owner = page;
+  }
+  return PageView(std::move(owner), data, page_number,
+                  nextUsedPage(page_number));
+}
+
+void File::adviseAccess(const AccessPattern pattern) {
+  open_file_->io->advise(pattern);
+}
+
+void File::writePages(const Page *const *pages, const std::size_t count,
+                      IOEngine *engine) {
+  std::lock_guard<std::recursive_mutex> guard(open_file_->latch);
+  FileIO &io = *open_file_->io;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!isPageUsed(pages[i]->page_number())) {
+      // Page has been deleted since it was read.
+      throw InvalidPageException(pages[i]->page_number(), filename_);
     }
   }
-  // Clear the page and add it to the head of the free list.
-  existing_page.initialize();
-  existing_page.set_next_page_number(header.first_free_page);
-  header.first_free_page = page_number;
-  ++header.num_free_pages;
-  if (previous_page.isUsed()) {
-    writePage(previous_page.page_number(), previous_page);
+
+  // Split the pages into runs of adjacent ones, as (first index, length).
+  std::vector<std::pair<std::size_t, std::size_t>> runs;
+  std::size_t start = 0;
+  while (start < count) {
+    const PageId first = pages[start]->page_number();
+    std::size_t run = 1;
+    while (start + run < count &&
+           pages[start + run]->page_number() == first + run) {
+      ++run;
+    }
+    runs.emplace_back(start, run);
+    start += run;
   }
-  writePage(page_number, existing_page);
-  writeHeader(header);
+
+  // Gathered from the pages as they are.
+  std::vector<iovec> iov;
+  int error = 0;
+  const IOEngine::Callback record = [&error](int result) {
+    if (error == 0) error = result;
+  };
+  for (const auto &run : runs) {
+    iov.resize(run.second);
+    for (std::size_t i = 0; i < run.second; ++i) {
+      iov[i].iov_base = const_cast<Page *>(pages[run.first + i]);
+      iov[i].iov_len = Page::SIZE;
+    }
+    const std::uint64_t position =
+        pagePosition(pages[run.first]->page_number());
+    if (engine == nullptr) {
+      io.writev(iov.data(), static_cast<int>(iov.size()), position);
+      continue;
+    }
+    // A request gathers at most IOV_MAX buffers.
+    for (std::size_t done = 0; done < iov.size(); done += IOV_MAX) {
+      const int buffers =
+          static_cast<int>(std::min<std::size_t>(IOV_MAX, iov.size() - done));
+      engine->queueWritev(io, iov.data() + done, buffers,
+                          position + done * Page::SIZE, record);
+    }
+  }
+  if (engine != nullptr) {
+    engine->wait();
+    if (error != 0) throw FileIOException(filename_, "write", error);
+  }
+}
+
+void File::applyDirectory(OpenFile &open_file, const PageId page_number,
+                          Page &page) {
+  bool used;
+  PageId next_page_number = Page::INVALID_NUMBER;
+  {
+    std::lock_guard<std::mutex> guard(open_file.metadata_mutex);
+    const PageId num_pages = open_file.header.num_pages;
+    used = page_number < num_pages && open_file.directory.isUsed(page_number);
+    if (used) {
+      next_page_number = open_file.directory.nextUsed(page_number, num_pages);
+    }
+  }
+  PageHeader &header = page.header_;
+  if (!used) {
+    header.current_page_number = Page::INVALID_NUMBER;
+    return;
+  }
+  if (!header.current_format) {
+    // Not written since the file was converted from version 1.
+    page.convertFromVersion1();
+  }
+  header.current_page_number = page_number;
+  header.next_page_number = next_page_number;
+}
+
+PageId File::nextUsedPage(const PageId after) const {
+  std::lock_guard<std::mutex> guard(open_file_->metadata_mutex);
+  return open_file_->directory.nextUsed(after, open_file_->header.num_pages);
+}
+
+void File::deletePage(const PageId page_number) {
+  std::lock_guard<std::recursive_mutex> guard(open_file_->latch);
+  if (!isPageUsed(page_number)) {
+    throw InvalidPageException(page_number, filename_);
+  }
+  // Clear the page, so that it reads as free even without the directory.
+  writePage(page_number, Page());
+  std::lock_guard<std::mutex> metadata(open_file_->metadata_mutex);
+  open_file_->directory.setUsed(page_number, false);
+  ++open_file_->header.num_free_pages;
+  open_file_->header_dirty = true;
 }
 
 FileIterator File::begin() {
-  const FileHeader &header = readHeader();
-  return FileIterator(this, header.first_used_page);
+  return FileIterator(this, nextUsedPage(Page::INVALID_NUMBER));
 }
 
 FileIterator File::end() { return FileIterator(this, Page::INVALID_NUMBER); }
 
-File::File(const std::string &name, const bool create_new)
-    : filename_(name), valid_(true) {
-  openIfNeeded(create_new);
-
-  if (create_new) {
-    // File starts with 1 page (the header).
-    FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
-    writeHeader(header);
-  }
+File::File(const std::string &name, const bool create_new,
+           const FileBackend backend)
+    : filename_(name), id_(INVALID_ID), valid_(true) {
+  openIfNeeded(create_new, backend);
 }
 
-void File::openIfNeeded(const bool create_new) {
-  if (open_counts_.find(filename_) !=
-      open_counts_.end()) {  // exists an entry already
-    ++open_counts_[filename_];
-    stream_ = open_streams_[filename_];
-  } else {
-    std::ios_base::openmode mode =
-        std::fstream::in | std::fstream::out | std::fstream::binary;
+void File::openIfNeeded(const bool create_new, const FileBackend backend) {
+  if (!valid_) {
+    // Empty File objects (e.g. unassigned buffer frames) own no stream.
+    return;
+  }
+  std::unique_lock<std::mutex> guard(open_files_mutex_);
+  OpenFileMap::iterator found;
+  // An expired entry is a file still being closed: wait for its header to be
+  // written back before reading it again.
+  while ((found = open_files_.find(filename_)) != open_files_.end() &&
+         !(open_file_ = found->second.lock())) {
+    open_files_closed_.wait(guard);
+  }
+  if (!open_file_) {
     const bool already_exists = exists(filename_);
     if (create_new) {
       // Error if we try to overwrite an existing file.
       if (already_exists) {
         throw FileExistsException(filename_);
       }
-      // New files have to be truncated on open.
-      mode = mode | std::fstream::trunc;
     } else {
       // Error if we try to open a file that doesn't exist.
       if (!already_exists) {
@@ -254,53 +495,262 @@ void File::openIfNeeded(const bool create_new) {
         throw FileNotFoundException(filename_);
       }
     }
-    stream_.reset(new std::fstream(filename_, mode));
-    open_streams_[filename_] = stream_;
-    open_counts_[filename_] = 1;
+    std::unique_ptr<OpenFile> open_file(new OpenFile());
+    open_file->filename = filename_;
+    open_file->extent_pages = DEFAULT_EXTENT_PAGES;
+    open_file->sync_policy = DEFAULT_SYNC_POLICY;
+    try {
+      open_file->io = FileIO::open(backend, filename_, create_new);
+      if (create_new) {
+        // File starts with 1 page (the header), which takes a whole block so
+        // that the pages after it are aligned.
+        open_file->header = {1 /* num_pages */,      0 /* first_used_page */,
+                             0 /* num_free_pages */, 0 /* first_free_page */,
+                             FileHeader::MAGIC,      FileHeader::VERSION};
+        open_file->header_dirty = true;
+        flushHeader(*open_file);
+      } else {
+        readMetadata(*open_file, backend);
+      }
+    } catch (...) {
+      valid_ = false;
+      throw;
+    }
+    if (file_ids_.find(filename_) == file_ids_.end()) {
+      // First time this name is opened: register it with the next free id.
+      const FileId next_id = static_cast<FileId>(file_ids_.size()) + 1;
+      file_ids_[filename_] = next_id;
+    }
+    open_file_ = std::shared_ptr<OpenFile>(open_file.release(), closeOpenFile);
+    open_files_[filename_] = open_file_;
+  }
+  id_ = file_ids_[filename_];
+}
+
+void File::readMetadata(OpenFile &open_file, const FileBackend backend) {
+  FileIO &io = *open_file.io;
+  alignas(FileIO::ALIGNMENT) char block[Page::SIZE];
+  io.read(block, Page::SIZE, 0 /* pos */);
+  std::memcpy(&open_file.header, block, sizeof(open_file.header));
+  open_file.header_dirty = false;
+  // Version 1 files have zeros or page 1 after their header.  The free space
+  // bounds that start page 1 are below Page::SIZE, so neither reads as
+  // MAGIC.
+  if (open_file.header.magic != FileHeader::MAGIC) {
+    convertFromVersion1(open_file, backend);
+    return;
+  }
+  if (open_file.header.version != FileHeader::VERSION) {
+    throw FileIOException(filename_, "read format version", EINVAL);
+  }
+  const std::uint64_t size = io.size();
+  if (size < static_cast<std::uint64_t>(open_file.header.num_pages) *
+                 Page::SIZE) {
+    throw FileIOException(filename_, "read pages", EINVAL);
+  }
+  if (size % Page::SIZE != 0) {
+    // An extension cut short by a crash, which the header does not count yet;
+    // the next one writes these pages again.
+    open_file.io.reset();
+    FileIO::truncate(filename_, size - size % Page::SIZE);
+    open_file.io = FileIO::open(backend, filename_, false /* create_new */);
+  }
+  PageDirectory &directory = open_file.directory;
+  directory.loadHeaderArea(block + PageDirectory::HEADER_AREA_OFFSET);
+  for (std::size_t i = 0; i < directory.directoryPages().size(); ++i) {
+    open_file.io->read(block, Page::SIZE,
+                       pagePosition(directory.directoryPages()[i]));
+    directory.loadDirectoryPage(i, block);
+  }
+}
+
+void File::convertFromVersion1(OpenFile &open_file,
+                               const FileBackend backend) {
+  FileHeader &header = open_file.header;
+  PageDirectory &directory = open_file.directory;
+  const PageId num_pages = header.num_pages;
+  // Page 1 directly follows the header in the unaligned layout, in which the
+  // file ends one header past a page boundary.
+  const bool unaligned =
+      open_file.io->size() % Page::SIZE == FileHeader::V1_SIZE;
+  const std::uint64_t first_page_position =
+      unaligned ? FileHeader::V1_SIZE : Page::SIZE;
+
+  // Directory pages for the pages past the header block go at the end.
+  PageId directory_pages = 0;
+  while (PageDirectory::HEADER_BITS +
+             directory_pages * PageDirectory::DIRECTORY_PAGE_BITS <
+         num_pages + directory_pages) {
+    ++directory_pages;
+  }
+  for (PageId i = 0; i < directory_pages; ++i) {
+    directory.addDirectoryPage(num_pages + i);
+  }
+  for (PageId i = 0; i < directory_pages; ++i) {
+    directory.setUsed(num_pages + i, true);
+  }
+
+  // Moving the pages in place could leave a crashed conversion with some
+  // pages moved and no way to tell which, so unaligned files are written
+  // into a copy instead.  Aligned files only gain directory pages past their
+  // end and, last, the new header.
+  const std::string converted = filename_ + ".convert";
+  std::unique_ptr<FileIO> source;
+  if (unaligned) {
+    std::remove(converted.c_str());
+    source = std::move(open_file.io);
+    open_file.io =
+        FileIO::open(FileBackend::POSIX, converted, true /* create_new */);
+  }
+  FileIO &in = unaligned ? *source : *open_file.io;
+
+  const PageId chunk_pages = 64;
+  AlignedBuffer buffer(chunk_pages * Page::SIZE);
+  PageId free_pages = 0;
+  for (PageId first = 1; first < num_pages; first += chunk_pages) {
+    const PageId end = std::min<PageId>(num_pages, first + chunk_pages);
+    const std::size_t size = (end - first) * Page::SIZE;
+    in.read(buffer.data(), size,
+            first_page_position +
+                static_cast<std::uint64_t>(first - 1) * Page::SIZE);
+    for (PageId i = 0; i < end - first; ++i) {
+      PageHeader page_header;
+      std::memcpy(&page_header, buffer.data() + i * Page::SIZE,
+                  sizeof(page_header));
+      if (page_header.current_page_number != Page::INVALID_NUMBER) {
+        directory.setUsed(first + i, true);
+      } else {
+        ++free_pages;
+      }
+    }
+    if (unaligned) {
+      open_file.io->write(buffer.data(), size, pagePosition(first));
+    }
+  }
+
+  header.num_pages = num_pages + directory_pages;
+  header.num_free_pages = free_pages;
+  header.magic = FileHeader::MAGIC;
+  header.version = FileHeader::VERSION;
+  open_file.header_dirty = true;
+  flushHeader(open_file);
+  if (unaligned) {
+    open_file.io->sync(false /* data_only */);
+    open_file.io.reset();
+    source.reset();
+    FileIO::replace(converted, filename_);
+    open_file.io = FileIO::open(backend, filename_, false /* create_new */);
   }
 }
 
 void File::close() {
-  --open_counts_[filename_];
-  stream_.reset();
-  if (open_counts_[filename_] == 0) {
-    open_streams_.erase(filename_);
-    open_counts_.erase(filename_);
+  // Dropping the last reference calls closeOpenFile().
+  open_file_.reset();
+}
+
+void File::closeOpenFile(OpenFile *open_file) {
+  std::unique_ptr<OpenFile> closed(open_file);
+  // Reopening the file waits while its expired entry is in open_files_, so
+  // the header can be written back and synced without holding the mutex and
+  // still reach the disk before the file is read again.
+  try {
+    syncFile(*closed);
+  } catch (const FileIOException &) {
+    // Nowhere to report it from here.
+  }
+  {
+    std::lock_guard<std::mutex> guard(open_files_mutex_);
+    open_files_.erase(closed->filename);
   }
+  open_files_closed_.notify_all();
 }
 
 void File::writePage(const PageId page_number, const Page &new_page) {
-  writePage(page_number, new_page.header_, new_page);
+  std::lock_guard<std::recursive_mutex> guard(open_file_->latch);
+  open_file_->io->write(reinterpret_cast<const char *>(&new_page), Page::SIZE,
+                        pagePosition(page_number));
 }
 
-void File::writePage(const PageId page_number, const PageHeader &header,
-                     const Page &new_page) {
-  stream_->seekp(pagePosition(page_number), std::ios::beg);
-  stream_->write(reinterpret_cast<const char *>(&header), sizeof(header));
-  stream_->write(&new_page.data_[0], Page::DATA_SIZE);
-  stream_->flush();
+FileHeader File::readHeader() const {
+  std::lock_guard<std::mutex> guard(open_file_->metadata_mutex);
+  return open_file_->header;
 }
 
-FileHeader File::readHeader() const {
-  FileHeader header;
-  stream_->seekg(0 /* pos */, std::ios::beg);
-  stream_->read(reinterpret_cast<char *>(&header), sizeof(header));
+void File::flush() { flushHeader(*open_file_); }
 
-  return header;
+void File::sync() { syncFile(*open_file_); }
+
+void File::setSyncPolicy(const SyncPolicy policy) {
+  open_file_->sync_policy = policy;
 }
 
-void File::writeHeader(const FileHeader &header) {
-  stream_->seekp(0 /* pos */, std::ios::beg);
-  stream_->write(reinterpret_cast<const char *>(&header), sizeof(header));
-  stream_->flush();
+SyncPolicy File::syncPolicy() const { return open_file_->sync_policy; }
+
+std::uint64_t File::deviceSyncs() const {
+  return open_file_->group_sync.runs();
 }
 
-PageHeader File::readPageHeader(PageId page_number) const {
-  PageHeader header;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char *>(&header), sizeof(header));
+void File::syncFile(OpenFile &open_file) {
+  flushHeader(open_file);
+  const SyncPolicy policy = open_file.sync_policy;
+  if (policy == SyncPolicy::NONE) {
+    return;
+  }
+  FileIO &io = *open_file.io;
+  if (policy == SyncPolicy::FLUSH) {
+    io.flush();
+    return;
+  }
+  open_file.group_sync.sync([&io, policy] {
+    io.flush();
+    io.sync(policy == SyncPolicy::DATASYNC /* data_only */);
+  });
+}
 
-  return header;
+void File::flushHeader(OpenFile &open_file) {
+  std::lock_guard<std::recursive_mutex> latch(open_file.latch);
+  alignas(FileIO::ALIGNMENT) char block[Page::SIZE] = {};
+  std::vector<std::size_t> dirty_pages;
+  std::unique_ptr<AlignedBuffer> pages;
+  {
+    std::lock_guard<std::mutex> guard(open_file.metadata_mutex);
+    if (!open_file.header_dirty) return;
+    PageDirectory &directory = open_file.directory;
+    FileHeader header = open_file.header;
+    header.first_used_page =
+        directory.nextUsed(Page::INVALID_NUMBER, header.num_pages);
+    header.first_free_page = header.num_free_pages > 0
+                                 ? directory.findFree(header.num_pages)
+                                 : Page::INVALID_NUMBER;
+    std::memcpy(block, &header, sizeof(header));
+    directory.storeHeaderArea(block + PageDirectory::HEADER_AREA_OFFSET);
+    dirty_pages = directory.takeDirtyPages();
+    if (!dirty_pages.empty()) {
+      pages.reset(new AlignedBuffer(dirty_pages.size() * Page::SIZE));
+      for (std::size_t i = 0; i < dirty_pages.size(); ++i) {
+        directory.storeDirectoryPage(dirty_pages[i],
+                                     pages->data() + i * Page::SIZE);
+      }
+    }
+    open_file.header_dirty = false;
+  }
+  try {
+    // Directory pages first: the header lists them.
+    for (std::size_t i = 0; i < dirty_pages.size(); ++i) {
+      const PageId page_number =
+          open_file.directory.directoryPages()[dirty_pages[i]];
+      open_file.io->write(pages->data() + i * Page::SIZE, Page::SIZE,
+                          pagePosition(page_number));
+    }
+    open_file.io->write(block, Page::SIZE, 0 /* pos */);
+  } catch (...) {
+    std::lock_guard<std::mutex> guard(open_file.metadata_mutex);
+    open_file.header_dirty = true;
+    for (const std::size_t index : dirty_pages) {
+      open_file.directory.markDirty(index);
+    }
+    throw;
+  }
 }
 
 }  // namespace badgerdb
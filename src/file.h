@@ -8,12 +8,22 @@
 
 #pragma once
 
-#include <fstream>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
+#include "file_io.h"
+#include "group_sync.h"
+#include "io_engine.h"
 #include "page.h"
+#include "page_directory.h"
+#include "page_view.h"
+#include "status.h"
 
 namespace badgerdb {
 
@@ -24,12 +34,34 @@ class FileIterator;
  */
 struct FileHeader {
   /**
-   * Number of pages allocated in the file.
+   * Value of magic in files with a format version.
+   */
+  static const std::uint32_t MAGIC = 0x46424442;  // "BDBF"
+
+  /**
+   * Version of the on-disk format written by this code: pages tracked by a
+   * PageDirectory, with deleted record space compacted lazily, free slots
+   * chained and slots packed in four bytes.  Version 1 files, with no magic,
+   * chained used and free pages through the next page numbers in their page
+   * headers, and their pages had six-byte slots, a free space lower bound
+   * and a count of free slots (see PageHeader::current_format).
+   */
+  static const std::uint32_t VERSION = 2;
+
+  /**
+   * Size of the header of version 1 files, which ends before magic.
+   */
+  static const std::size_t V1_SIZE = 4 * sizeof(PageId);
+
+  /**
+   * Number of pages allocated in the file, including the header and directory
+   * pages.
    */
   PageId num_pages;
 
   /**
-   * Page number of the first used page in the file.
+   * Page number of the first used page in the file, as of the last time the
+   * header was written.
    */
   PageId first_used_page;
 
@@ -39,10 +71,21 @@ struct FileHeader {
   PageId num_free_pages;
 
   /**
-   * Page number of the first free (allocated but unused) page in the file.
+   * Page number of the first free (allocated but unused) page in the file, as
+   * of the last time the header was written.
    */
   PageId first_free_page;
 
+  /**
+   * MAGIC, for files with a format version.
+   */
+  std::uint32_t magic;
+
+  /**
+   * Version of the on-disk format of the file.
+   */
+  std::uint32_t version;
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -52,49 +95,104 @@ struct FileHeader {
   bool operator==(const FileHeader &rhs) const {
     return num_pages == rhs.num_pages && num_free_pages == rhs.num_free_pages &&
            first_used_page == rhs.first_used_page &&
-           first_free_page == rhs.first_free_page;
+           first_free_page == rhs.first_free_page && magic == rhs.magic &&
+           version == rhs.version;
   }
 };
 
+static_assert(sizeof(FileHeader) <= PageDirectory::HEADER_AREA_OFFSET,
+              "the FileHeader must fit before the page directory");
+
+/**
+ * @brief Run of consecutive pages in a file.
+ */
+struct PageRun {
+  /**
+   * Number of the first page of the run.
+   */
+  PageId first;
+
+  /**
+   * Number of pages in the run.
+   */
+  PageId count;
+};
+
 /**
  * @brief Class which represents a file in the filesystem containing database
  *        pages.
  *
- * The File class wraps a stream to an underlying file on disk.  Files contain
+ * The File class wraps an underlying file on disk, accessed through a FileIO
+ * backend (pread()/pwrite() by default).  Files contain
  * fixed-sized pages, and they never deallocate space (though they do reuse
  * deleted pages if possible).  If multiple File objects refer to the same
- * underlying file, they will share the stream in memory.
+ * underlying file, they will share the FileIO in memory.
  * If a file that has already been opened (possibly by another query), then the
- * File class detects this (by looking in the open_streams_ map) and just
- * returns a file object with the already created stream for the file without
+ * File class detects this (by looking in the open_files_ map) and just
+ * returns a file object with the already created FileIO for the file without
  * actually opening the UNIX file again.
  *
- * @warning This class is not threadsafe.
+ * The header takes a block of Page::SIZE bytes of its own, so page n starts at
+ * offset n * Page::SIZE and every page is aligned for direct I/O.  The rest of
+ * the block holds the start of the PageDirectory, a bitmap of the used pages,
+ * which is kept in memory while the file is open; allocating, deleting and
+ * checking a page take no page reads.  Version 1 files, which chained their
+ * pages through the page headers (and, if old enough, had page 1 directly
+ * follow the FileHeader), get a directory when first opened; their pages are
+ * converted to the current format as they are read, and written back in it
+ * when next written.
+ *
+ * File objects may be shared between threads.  Every File object referring to
+ * the same underlying file also shares a latch, which serializes writes and
+ * compound operations such as allocatePage() and deletePage().  Reads take no
+ * latch, so with the POSIX backend they run concurrently with each other and
+ * with writes to other pages.
  */
 class File {
  public:
+  /**
+   * Id of empty (invalid) File objects.
+   */
+  static const FileId INVALID_ID = 0;
+
+  /**
+   * Default most pages by which a file grows at once; see setExtentPages().
+   */
+  static const PageId DEFAULT_EXTENT_PAGES = 64;
+
+  /**
+   * SyncPolicy of a file until setSyncPolicy() is called.
+   */
+  static const SyncPolicy DEFAULT_SYNC_POLICY = SyncPolicy::FLUSH;
+
   /**
    * Creates a new file.
    *
    * @param filename  Name of the file.
+   * @param backend   How to do I/O on the file.
    * @throws  FileExistsException     If the requested file already exists.
    */
-  static File create(const std::string &filename);
+  static File create(const std::string &filename,
+                     const FileBackend backend = FileBackend::POSIX);
 
   /**
    * Opens the file named fileName and returns the corresponding File object.
    * It first checks if the file is already open. If so, then the new File
    * object created uses the same input-output stream to read to or write fom
-   * that already open file. Reference count (open_counts_ static variable
-   * inside the File object) is incremented whenever an already open file is
-   * opened again. Otherwise the UNIX file is actually opened. The fileName and
-   * the stream associated with this File object are inserted into the
-   * open_streams_ map.
+   * that already open file, and the OpenFile shared by all File objects (and
+   * buffer frames) for the file gains a reference. Otherwise the UNIX file is
+   * actually opened. The fileName and the OpenFile associated with this File
+   * object are inserted into the open_files_ map, until the last reference to
+   * the OpenFile is dropped.
    *
    * @param filename  Name of the file.
+   * @param backend   How to do I/O on the file, if it is not open yet.
    * @throws  FileNotFoundException   If the requested file doesn't exist.
+   * @throws  FileIOException         If the file cannot be opened, read or
+   *                                  converted from version 1.
    */
-  static File open(const std::string &filename);
+  static File open(const std::string &filename,
+                   const FileBackend backend = FileBackend::POSIX);
 
   /**
    * Deletes an existing file.
@@ -140,14 +238,14 @@ class File {
    * @param rhs File object to compare.
    * @return True if the two files are equal.
    */
-  bool operator==(const File &rhs) const { return filename_ == rhs.filename_; }
+  bool operator==(const File &rhs) const { return id_ == rhs.id_; }
 
   /**
    * Check if two files are not equal.
    * @param rhs File object to compare.
    * @return True if the two files are not equal.
    */
-  bool operator!=(const File &rhs) const { return filename_ != rhs.filename_; }
+  bool operator!=(const File &rhs) const { return id_ != rhs.id_; }
 
   /**
    * Destructor that automatically closes the underlying file if no other
@@ -156,12 +254,45 @@ class File {
   ~File();
 
   /**
-   * Allocates a new page in the file.
+   * Allocates a new page in the file: the lowest-numbered free page, growing
+   * the file by an extent if there is none.  Free pages are kept empty on
+   * disk, so this writes no page; only growing the file does.
    *
    * @return The new page.
+   * @throws  FileFullException   If the file has run out of page numbers.
    */
   Page allocatePage();
 
+  /**
+   * Allocates count new pages numbered consecutively, with a single update of
+   * the directory: the lowest run of free pages long enough, growing the file
+   * if there is none.  Like allocatePage(), this writes no page unless the
+   * file grows; the pages read as empty until written.
+   *
+   * @param count   Number of pages to allocate, from 1 to
+   *                PageDirectory::DIRECTORY_PAGE_BITS - 1, the most pages
+   *                between two directory pages.
+   * @return  The new pages.
+   * @throws  InvalidPageCountException   If count is out of that range.
+   * @throws  FileFullException   If the file has run out of page numbers.
+   */
+  PageRun allocatePages(const PageId count);
+
+  /**
+   * Sets the most pages by which the file grows at once.  A file grows by as
+   * many pages as it has, up to this many, reserving the space with one
+   * FileIO::allocate() and writing the new, empty pages with one write.
+   * Shared by all File objects for the file until it is closed.
+   *
+   * @param pages   Extent size in pages, at least 1.
+   */
+  void setExtentPages(const PageId pages);
+
+  /**
+   * Returns the most pages by which the file grows at once.
+   */
+  PageId extentPages() const;
+
   /**
    * Reads an existing page from the file.
    *
@@ -172,19 +303,167 @@ class File {
    */
   Page readPage(const PageId page_number) const;
 
+  /**
+   * Reads an existing page from the file into the given page, e.g. a buffer
+   * pool frame, straight from the FileIO: no temporary page is made, and
+   * nothing is allocated on the heap.
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Page to read into.  Unspecified on failure.
+   * @throws  InvalidPageException  If the page doesn't exist in the file or is
+   *                                not currently used.
+   */
+  void readPageInto(const PageId page_number, Page &page) const;
+
+  /**
+   * Non-throwing variant of readPageInto().
+   *
+   * @param page_number   Number of page to read.
+   * @param page          Set to the page read.  Unspecified on failure.
+   * @return  Status::INVALID_PAGE if the page doesn't exist in the file or is
+   *          not currently used, Status::OK otherwise.
+   */
+  Status tryReadPage(const PageId page_number, Page &page) const;
+
+  /**
+   * Reads the run of pages [first, first + count), clipped to the end of the
+   * file, with one vectored read straight into the given pages.  Free pages
+   * are read as well, with page_number() Page::INVALID_NUMBER.
+   *
+   * @param first   Number of first page to read.
+   * @param count   Number of pages to read.
+   * @param pages   Pages to read into, count of them.
+   * @return  Number of pages read, 0 if first is not a page of the file.
+   * @throws  FileIOException   If the read fails.
+   */
+  PageId readPages(const PageId first, const PageId count,
+                   Page *const *pages) const;
+
+  /**
+   * Reads the pages with the given numbers, which must be sorted, with one
+   * vectored read per run of adjacent pages.  Free pages, and pages past the
+   * end of the file, are read as free pages, with page_number()
+   * Page::INVALID_NUMBER.
+   *
+   * @param page_numbers  Numbers of the pages to read, in ascending order.
+   * @param count         Number of pages to read.
+   * @param pages         Pages to read into, count of them.
+   * @throws  FileIOException   If a read fails; pages of the runs not read
+   *                            yet are unspecified then.
+   */
+  void readPages(const PageId *page_numbers, const std::size_t count,
+                 Page *const *pages) const;
+
+  /**
+   * Returns whether a page exists in the file and is currently used, from the
+   * PageDirectory in memory.
+   *
+   * @param page_number   Number of page to check.
+   */
+  bool isPageUsed(const PageId page_number) const;
+
+  /**
+   * Queues a read of a page on an IOEngine, so that many reads can be in
+   * flight at once.  The page is set, and done called, when the engine
+   * completes the read.  Free pages are read as well, so callers check
+   * Page::isUsed(); pages past the end of the file read as free.
+   *
+   * @param engine        Engine to queue the read on.
+   * @param page_number   Number of page to read.
+   * @param page          Page to read into; must outlive the request.
+   * @param done          Called with 0 or the errno value of the failure.
+   */
+  void readPageAsync(IOEngine &engine, const PageId page_number, Page &page,
+                     IOEngine::Callback done) const;
+
+  /**
+   * Returns a read-only view of a page.  With FileBackend::MMAP the page is
+   * not copied; see PageView.
+   *
+   * @param page_number   Number of page to view.
+   * @return  View of the page.
+   * @throws  InvalidPageException  If the page doesn't exist in the file or is
+   *                                not currently used.
+   */
+  PageView viewPage(const PageId page_number) const;
+
+  /**
+   * Tells the operating system how the file is going to be accessed, e.g.
+   * randomly for point lookups, so that it can adjust its read-ahead.
+   *
+   * @param pattern   Expected access pattern.
+   */
+  void adviseAccess(const AccessPattern pattern);
+
+  /**
+   * Writes the file header back if it has changed.  Pages are written as they
+   * are written to the File, but the header (page count and PageDirectory)
+   * is kept in memory, shared by all File objects for the file, and only
+   * written here, by sync() and when the last of them is closed.  Like page
+   * writes, this makes nothing durable; see sync().
+   *
+   * @throws  FileIOException   If the write fails.
+   */
+  void flush();
+
+  /**
+   * Makes everything written to the file so far as durable as its SyncPolicy
+   * asks: writes the header back as flush() does, then hands the writes over
+   * to the operating system and forces them to the device with fdatasync()
+   * or fsync().  Concurrent calls, e.g. by committing transactions, share a
+   * single fdatasync() or fsync() (see GroupSync).  The last File object to
+   * close the file syncs it as well.
+   *
+   * @throws  FileIOException   If a write or the sync fails.
+   */
+  void sync();
+
+  /**
+   * Sets how durable sync() makes the file, e.g. SyncPolicy::NONE for
+   * temporary files.  Shared by all File objects for the file until it is
+   * closed.
+   *
+   * @param policy  The policy.
+   */
+  void setSyncPolicy(const SyncPolicy policy);
+
+  /**
+   * Returns how durable sync() makes the file.
+   */
+  SyncPolicy syncPolicy() const;
+
+  /**
+   * Returns the number of times the file has been forced to the device since
+   * it was opened; concurrent sync() calls share one.
+   */
+  std::uint64_t deviceSyncs() const;
+
   /**
    * Writes a page into the file, replacing any existing contents.  The page
    * must have been already allocated in this file by a call to allocatePage().
+   * The write goes to the FileIO without being flushed; see sync().
    *
    * @see allocatePage()
    * @param new_page  Page to write.
+   * @throws  InvalidPageException  If the page is not currently used.
+   */
+  void writePage(const Page &new_page) { writePageFrom(new_page); }
+
+  /**
+   * Writes a page as writePage() does, with a single write straight from
+   * where it is, e.g. a buffer pool frame, without copying it first.
+   *
+   * @param page  Page to write.
+   * @throws  InvalidPageException  If the page is not currently used.
    */
-  void writePage(const Page &new_page);
+  void writePageFrom(const Page &page);
 
   /**
-   * Deletes a page from the file.
+   * Deletes a page from the file.  The page is cleared on disk and reused by
+   * a later allocatePage().
    *
    * @param page_number   Number of page to delete.
+   * @throws  InvalidPageException  If the page is not currently used.
    */
   void deletePage(const PageId page_number);
 
@@ -196,7 +475,18 @@ class File {
   const std::string &filename() const { return filename_; }
 
   /**
-   * Returns an iterator at the first page in the file.
+   * Returns the id of the file this object represents.  Ids are assigned by a
+   * process-wide registry the first time a file name is opened and never
+   * change or get reused afterwards, so (id(), page number) identifies a page
+   * with two integers.
+   *
+   * @return Id of file, or INVALID_ID for an empty File object.
+   */
+  FileId id() const { return id_; }
+
+  /**
+   * Returns an iterator at the first page in the file.  Iterators visit the
+   * used pages in ascending page number order.
    *
    * @return  Iterator at first page of file.
    */
@@ -221,9 +511,10 @@ class File {
    * Creates an empty file
    * @return File object with valid_ bit set to false
    */
-  File() : valid_(false) {}
+  File() : id_(INVALID_ID), valid_(false) {}
 
  private:
+  friend class BufDesc;
   friend class BufMgr;
 
   /**
@@ -235,12 +526,74 @@ class File {
    * @see File::open()
    * @param name        Name of file.
    * @param create_new  Whether to create a new file.
+   * @param backend     How to do I/O on the file.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  explicit File(const std::string &name, const bool create_new);
+  explicit File(const std::string &name, const bool create_new,
+                const FileBackend backend);
+
+  /**
+   * @brief State shared by all File objects for the same underlying file.
+   */
+  struct OpenFile {
+    /**
+     * Name of the file.
+     */
+    std::string filename;
+
+    /**
+     * I/O backend for the underlying filesystem object.
+     */
+    std::unique_ptr<FileIO> io;
+
+    /**
+     * Latch serializing writes and compound operations among all File objects
+     * for the file.  Recursive because compound operations (allocatePage(),
+     * deletePage()) are built from the primitive writes.
+     */
+    std::recursive_mutex latch;
+
+    /**
+     * Most pages by which the file grows at once.  Guarded by latch.
+     */
+    PageId extent_pages;
+
+    /**
+     * How durable sync() makes the file.
+     */
+    std::atomic<SyncPolicy> sync_policy;
+
+    /**
+     * Lets concurrent sync() calls share forcing the file to the device.
+     */
+    GroupSync group_sync;
+
+    /**
+     * The file header, read from disk when the file is opened and written
+     * back by flush() and when the last reference to the file is dropped.
+     */
+    FileHeader header;
+
+    /**
+     * Which pages are used, read from disk when the file is opened and written
+     * back with header.
+     */
+    PageDirectory directory;
+
+    /**
+     * Whether header or directory has changed since they were last written.
+     */
+    bool header_dirty;
+
+    /**
+     * Guards header, directory and header_dirty, so that reads need not take
+     * latch.
+     */
+    std::mutex metadata_mutex;
+  };
 
   /**
    * Returns the position of the page with the given number in the file (as an
@@ -249,44 +602,140 @@ class File {
    * @param page_number   Number of page.
    * @return  Position of page in file.
    */
-  static std::streampos pagePosition(const PageId page_number) {
-    return sizeof(FileHeader) + ((page_number - 1) * Page::SIZE);
+  static std::uint64_t pagePosition(const PageId page_number) {
+    return static_cast<std::uint64_t>(page_number) * Page::SIZE;
   }
 
+  /**
+   * Reads the run of pages [first, first + count), all within the file, with
+   * a single FileIO::readv() straight into the pages.
+   *
+   * @param first   Number of first page to read.
+   * @param count   Number of pages to read.
+   * @param pages   Pages to read into, count of them.
+   */
+  void readRun(const PageId first, const std::size_t count,
+               Page *const *pages) const;
+
+  /**
+   * Writes the given pages, which must be sorted by page number, replacing
+   * their contents as writePage() does.  Each run of adjacent pages is written
+   * with a single call gathering the pages from where they are.  With an
+   * engine, the writes of all runs are in flight at once.
+   *
+   * @param pages   Pages to write.
+   * @param count   Number of pages.
+   * @param engine  Engine to issue the writes on, or null to issue them one
+   *                at a time.
+   * @throws  InvalidPageException  If a page has been deleted; nothing is
+   *                                written then.
+   * @throws  FileIOException       If a request on the engine fails.
+   */
+  void writePages(const Page *const *pages, const std::size_t count,
+                  IOEngine *engine = nullptr);
+
+  /**
+   * Adds at least min_free_pages free pages at the end of the file, a whole
+   * extent if that is more.  Directory pages the file needs on the way are
+   * taken as well.
+   *
+   * @param min_free_pages  Number of free pages needed.
+   * @throws  FileFullException   If the file has run out of page numbers.
+   */
+  void extend(const PageId min_free_pages);
+
+  /**
+   * Completes a page read from disk: converts it to the current format if it
+   * is a version 1 page still in use, and fills in its header with what the
+   * directory of the file knows, the number of the page and of the next used
+   * page, or that the page is free.  Directory pages, for one, read as free.
+   * Every read of a page goes through here.
+   *
+   * @param open_file     State of the file.
+   * @param page_number   Number of the page.
+   * @param page          Page as read.
+   */
+  static void applyDirectory(OpenFile &open_file, const PageId page_number,
+                             Page &page);
+
+  /**
+   * Returns the first used page after the given one, or Page::INVALID_NUMBER
+   * if there is none.
+   *
+   * @param after   Page to search after; Page::INVALID_NUMBER for the first
+   *                used page of the file.
+   */
+  PageId nextUsedPage(const PageId after) const;
+
   /**
    * Opens the underlying file named in filename_.
    * This method only opens the file if no other File objects exist that access
-   * the same filesystem file; otherwise, it reuses the existing stream.
+   * the same filesystem file; otherwise, it reuses the existing FileIO.
    *
    * @param create_new  Whether to create a new file.
+   * @param backend     How to do I/O on the file, if it is not open yet.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  void openIfNeeded(const bool create_new);
+  void openIfNeeded(const bool create_new,
+                    const FileBackend backend = FileBackend::POSIX);
+
+  /**
+   * Reads the header and directory of a newly opened file, giving it a
+   * directory if it is a version 1 file.
+   *
+   * @param open_file   State of the file, with io open.
+   * @param backend     Backend io was opened with.
+   * @throws  FileIOException   If reading fails, or the file has a newer
+   *                            format version.
+   */
+  void readMetadata(OpenFile &open_file, const FileBackend backend);
 
   /**
-   * Closes the underlying file stream in <stream_>.
-   * This method only closes the file if no other File objects exist that access
-   * the same file.
+   * Converts a version 1 file, whose header has been read, to
+   * FileHeader::VERSION: builds its directory from the page headers, moves
+   * the pages to the aligned layout if needed, and writes the new header.
+   * The pages themselves are left in the old format for applyDirectory() to
+   * convert.
+   *
+   * Files in the unaligned layout are copied into "<name>.convert", which is
+   * renamed over the original once complete, so that a crash leaves either
+   * the untouched version 1 file or the converted one.  Any such copy left
+   * by an earlier crash is discarded.
+   *
+   * @param open_file   State of the file, with io open; io is reopened on the
+   *                    converted file.
+   * @param backend     Backend io was opened with.
+   */
+  void convertFromVersion1(OpenFile &open_file, const FileBackend backend);
+
+  /**
+   * Drops the reference of this object to <open_file_>, closing the
+   * underlying file if no other File objects or buffer frames refer to it.
    */
   void close();
 
   /**
-   * Reads a page from the file.  If <allow_free> is not set, an exception
-   * will be thrown if the page read from disk is not currently in use.
+   * Deleter of OpenFile: writes back the header and syncs the file as its
+   * SyncPolicy asks, outside open_files_mutex_, then removes it from
+   * open_files_.  A failed write is ignored; call sync() first to see it.
    *
-   * No bounds checking is performed; the underlying file stream will throw
-   * an exception if the page is past the end of the file.
+   * @param open_file   State of the file, no longer referenced.
+   */
+  static void closeOpenFile(OpenFile *open_file);
+
+  /**
+   * Writes a page through the given open file, as writePageFrom() does.  For
+   * holders of the state of a file rather than a File object, such as buffer
+   * frames.
    *
-   * @param page_number   Number of page to read.
-   * @param allow_free    Whether to allow reading a free (unused) page.
-   * @return  The page.
-   * @throws  InvalidPageException  If the page is free (unused) and
-   *                                allow_free is false.
+   * @param open_file   State of the file.
+   * @param page        Page to write.
+   * @throws  InvalidPageException  If the page is not currently used.
    */
-  Page readPage(const PageId page_number, const bool allow_free) const;
+  static void writePageFrom(OpenFile &open_file, const Page &page);
 
   /**
    * Writes a page into the file at the given page number.  This does not
@@ -299,52 +748,55 @@ class File {
   void writePage(const PageId page_number, const Page &new_page);
 
   /**
-   * Writes a page into the file at the given page number with the given header.
-   * This does not ensure that the number in the header equals the position on
-   * disk.  No bounds checking is performed.
+   * Returns the header for this file, from memory.
    *
-   * @param page_number Number of page whose contents to replace.
-   * @param header      Header of page to write.
-   * @param new_page    Page to write.
+   * @return  The file header.
    */
-  void writePage(const PageId page_number, const PageHeader &header,
-                 const Page &new_page);
+  FileHeader readHeader() const;
 
   /**
-   * Reads the header for this file from disk.
+   * Writes the cached header and directory of an open file to disk if they
+   * have changed.
    *
-   * @return  The file header.
+   * @param open_file   State of the file.
+   * @throws  FileIOException   If the write fails.
    */
-  FileHeader readHeader() const;
+  static void flushHeader(OpenFile &open_file);
 
   /**
-   * Writes the given header to the disk as the header for this file.
+   * Writes back the header of an open file and syncs it as its SyncPolicy
+   * asks.
    *
-   * @param header  File header to write.
+   * @param open_file   State of the file.
+   * @throws  FileIOException   If a write or the sync fails.
    */
-  void writeHeader(const FileHeader &header);
+  static void syncFile(OpenFile &open_file);
+
+  typedef std::map<std::string, std::weak_ptr<OpenFile>> OpenFileMap;
+  typedef std::map<std::string, FileId> IdMap;
 
   /**
-   * Reads only the header of the given page from disk (not the record data
-   * or slot table).  No bounds checking is performed.
-   *
-   * @param page_number   Number of page whose header is to be read.
-   * @return  Header of page.
+   * Shared state of opened files.  The File objects and buffer frames that
+   * refer to a file own its OpenFile; an entry that has expired belongs to a
+   * file being closed by closeOpenFile().
    */
-  PageHeader readPageHeader(const PageId page_number) const;
+  static OpenFileMap open_files_;
 
-  typedef std::map<std::string, std::shared_ptr<std::fstream>> StreamMap;
-  typedef std::map<std::string, int> CountMap;
+  /**
+   * Ids of every file name opened so far.
+   */
+  static IdMap file_ids_;
 
   /**
-   * Streams for opened files.
+   * Guards open_files_ and file_ids_.
    */
-  static StreamMap open_streams_;
+  static std::mutex open_files_mutex_;
 
   /**
-   * Counts for opened files.
+   * Signalled when closeOpenFile() removes a file from open_files_, so that
+   * reopening it waits for its header to be written back first.
    */
-  static CountMap open_counts_;
+  static std::condition_variable open_files_closed_;
 
   /**
    * Name of the file this object represents.
@@ -352,9 +804,14 @@ class File {
   std::string filename_;
 
   /**
-   * Stream for underlying filesystem object.
+   * Id of the file this object represents.
+   */
+  FileId id_;
+
+  /**
+   * State of the underlying file, shared with the other File objects for it.
    */
-  std::shared_ptr<std::fstream> stream_;
+  std::shared_ptr<OpenFile> open_file_;
 
   /**
    * Whether this file is valid.
@@ -0,0 +1,577 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "file_io.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "exceptions/file_io_exception.h"
+
+namespace badgerdb {
+
+const std::size_t FileIO::ALIGNMENT;
+
+AlignedBuffer::AlignedBuffer(const std::size_t size) : size_(size) {
+  void *data;
+  if (posix_memalign(&data, FileIO::ALIGNMENT, size) != 0) {
+    throw std::bad_alloc();
+  }
+  data_.reset(static_cast<char *>(data));
+}
+
+void AlignedBuffer::Free::operator()(char *data) const { std::free(data); }
+
+std::unique_ptr<FileIO> FileIO::open(const FileBackend backend,
+                                     const std::string &filename,
+                                     const bool create_new) {
+  switch (backend) {
+    case FileBackend::STREAM:
+      return std::unique_ptr<FileIO>(new StreamFileIO(filename, create_new));
+    case FileBackend::DIRECT:
+      return std::unique_ptr<FileIO>(new DirectFileIO(filename, create_new));
+    case FileBackend::MMAP:
+      return std::unique_ptr<FileIO>(new MmapFileIO(filename, create_new));
+    case FileBackend::POSIX:
+    default:
+      return std::unique_ptr<FileIO>(new PosixFileIO(filename, create_new));
+  }
+}
+
+void FileIO::replace(const std::string &from, const std::string &to) {
+  if (::rename(from.c_str(), to.c_str()) != 0) {
+    throw FileIOException(from, "rename", errno);
+  }
+  const std::string::size_type slash = to.rfind('/');
+  const std::string directory =
+      slash == std::string::npos ? "." : to.substr(0, slash + 1);
+  const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    throw FileIOException(directory, "open", errno);
+  }
+  const int result = ::fsync(fd);
+  const int error = errno;
+  ::close(fd);
+  if (result != 0) {
+    throw FileIOException(directory, "sync", error);
+  }
+}
+
+void FileIO::truncate(const std::string &filename,
+                      const std::uint64_t size) {
+  if (::truncate(filename.c_str(), static_cast<off_t>(size)) != 0) {
+    throw FileIOException(filename, "truncate", errno);
+  }
+}
+
+void FileIO::readv(const iovec *iov, const int count,
+                   const std::uint64_t offset) {
+  if (count == 1) {
+    read(static_cast<char *>(iov[0].iov_base), iov[0].iov_len, offset);
+    return;
+  }
+  std::size_t size = 0;
+  for (int i = 0; i < count; ++i) {
+    size += iov[i].iov_len;
+  }
+  AlignedBuffer staging(size);
+  read(staging.data(), size, offset);
+  const char *source = staging.data();
+  for (int i = 0; i < count; ++i) {
+    std::memcpy(iov[i].iov_base, source, iov[i].iov_len);
+    source += iov[i].iov_len;
+  }
+}
+
+void FileIO::writev(const iovec *iov, const int count,
+                    const std::uint64_t offset) {
+  if (count == 1) {
+    write(static_cast<const char *>(iov[0].iov_base), iov[0].iov_len, offset);
+    return;
+  }
+  std::size_t size = 0;
+  for (int i = 0; i < count; ++i) {
+    size += iov[i].iov_len;
+  }
+  AlignedBuffer staging(size);
+  char *target = staging.data();
+  for (int i = 0; i < count; ++i) {
+    std::memcpy(target, iov[i].iov_base, iov[i].iov_len);
+    target += iov[i].iov_len;
+  }
+  write(staging.data(), size, offset);
+}
+
+PosixFileIO::PosixFileIO(const std::string &filename, const bool create_new)
+    : PosixFileIO(filename, create_new, 0 /* flags */) {}
+
+PosixFileIO::PosixFileIO(const std::string &filename, const bool create_new,
+                         const int flags)
+    : FileIO(filename) {
+  const int all_flags =
+      flags | O_RDWR | O_CLOEXEC | (create_new ? O_CREAT | O_TRUNC : 0);
+  fd_ = ::open(filename.c_str(), all_flags, 0644);
+  if (fd_ < 0) {
+    throw FileIOException(filename_, "open", errno);
+  }
+}
+
+PosixFileIO::~PosixFileIO() { ::close(fd_); }
+
+void PosixFileIO::read(char *buffer, const std::size_t size,
+                       const std::uint64_t offset) {
+  std::size_t done = 0;
+  while (done < size) {
+    const ssize_t count = ::pread(fd_, buffer + done, size - done,
+                                  static_cast<off_t>(offset + done));
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw FileIOException(filename_, "read", errno);
+    }
+    if (count == 0) {
+      // End of file.
+      std::memset(buffer + done, 0, size - done);
+      return;
+    }
+    done += count;
+  }
+}
+
+void PosixFileIO::readv(const iovec *iov, const int count,
+                        const std::uint64_t offset) {
+  int index = 0;
+  std::uint64_t position = offset;
+  while (index < count) {
+    const ssize_t got = ::preadv(fd_, iov + index, std::min(count - index, IOV_MAX),
+                                 static_cast<off_t>(position));
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw FileIOException(filename_, "read", errno);
+    }
+    if (got == 0) {
+      // End of file.
+      for (; index < count; ++index) {
+        std::memset(iov[index].iov_base, 0, iov[index].iov_len);
+      }
+      return;
+    }
+    position += got;
+    std::size_t left = got;
+    while (index < count && left >= iov[index].iov_len) {
+      left -= iov[index].iov_len;
+      ++index;
+    }
+    if (left > 0) {
+      // Short read: finish the buffer it stopped in.
+      const std::size_t rest = iov[index].iov_len - left;
+      PosixFileIO::read(static_cast<char *>(iov[index].iov_base) + left, rest,
+                        position);
+      position += rest;
+      ++index;
+    }
+  }
+}
+
+void PosixFileIO::write(const char *buffer, const std::size_t size,
+                        const std::uint64_t offset) {
+  std::size_t done = 0;
+  while (done < size) {
+    const ssize_t count = ::pwrite(fd_, buffer + done, size - done,
+                                   static_cast<off_t>(offset + done));
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw FileIOException(filename_, "write", errno);
+    }
+    done += count;
+  }
+}
+
+void PosixFileIO::writev(const iovec *iov, const int count,
+                         const std::uint64_t offset) {
+  int index = 0;
+  std::uint64_t position = offset;
+  while (index < count) {
+    const ssize_t wrote = ::pwritev(fd_, iov + index,
+                                    std::min(count - index, IOV_MAX),
+                                    static_cast<off_t>(position));
+    if (wrote < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw FileIOException(filename_, "write", errno);
+    }
+    position += wrote;
+    std::size_t left = wrote;
+    while (index < count && left >= iov[index].iov_len) {
+      left -= iov[index].iov_len;
+      ++index;
+    }
+    if (left > 0) {
+      // Short write: finish the buffer it stopped in.
+      const std::size_t rest = iov[index].iov_len - left;
+      PosixFileIO::write(static_cast<const char *>(iov[index].iov_base) + left,
+                         rest, position);
+      position += rest;
+      ++index;
+    }
+  }
+}
+
+namespace {
+
+/**
+ * Forces a file to the device through a descriptor of it.  Returns 0 or the
+ * errno value of the failure.
+ */
+int syncDescriptor(const int fd, const bool data_only) {
+  while ((data_only ? ::fdatasync(fd) : ::fsync(fd)) != 0) {
+    if (errno != EINTR) {
+      return errno;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+void PosixFileIO::sync(const bool data_only) {
+  const int error = syncDescriptor(fd_, data_only);
+  if (error != 0) {
+    throw FileIOException(filename_, "sync", error);
+  }
+}
+
+std::uint64_t PosixFileIO::size() {
+  struct stat status;
+  if (::fstat(fd_, &status) != 0) {
+    throw FileIOException(filename_, "stat", errno);
+  }
+  return status.st_size;
+}
+
+namespace {
+
+/**
+ * Returns the posix_fadvise() advice for an access pattern.
+ */
+int fileAdvice(const AccessPattern pattern) {
+  switch (pattern) {
+    case AccessPattern::RANDOM:
+      return POSIX_FADV_RANDOM;
+    case AccessPattern::SEQUENTIAL:
+      return POSIX_FADV_SEQUENTIAL;
+    case AccessPattern::NORMAL:
+      break;
+  }
+  return POSIX_FADV_NORMAL;
+}
+
+/**
+ * Returns the madvise() advice for an access pattern.
+ */
+int memoryAdvice(const AccessPattern pattern) {
+  switch (pattern) {
+    case AccessPattern::RANDOM:
+      return MADV_RANDOM;
+    case AccessPattern::SEQUENTIAL:
+      return MADV_SEQUENTIAL;
+    case AccessPattern::NORMAL:
+      break;
+  }
+  return MADV_NORMAL;
+}
+
+}  // namespace
+
+void PosixFileIO::advise(const AccessPattern pattern) {
+  // Only a hint: failures are ignored.
+  ::posix_fadvise(fd_, 0, 0, fileAdvice(pattern));
+}
+
+void PosixFileIO::allocate(const std::uint64_t offset,
+                           const std::uint64_t size) {
+  while (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+                     static_cast<off_t>(size)) != 0) {
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EOPNOTSUPP || errno == ENOSYS) {
+      // The filesystem cannot reserve space; writes will allocate it.
+      return;
+    }
+    throw FileIOException(filename_, "allocate", errno);
+  }
+}
+
+DirectFileIO::DirectFileIO(const std::string &filename, const bool create_new)
+    : PosixFileIO(filename, create_new, O_DIRECT) {}
+
+bool DirectFileIO::isAligned(const void *buffer, const std::size_t size,
+                             const std::uint64_t offset) {
+  return reinterpret_cast<std::uintptr_t>(buffer) % ALIGNMENT == 0 &&
+         size % ALIGNMENT == 0 && offset % ALIGNMENT == 0;
+}
+
+bool DirectFileIO::isAligned(const iovec *iov, const int count,
+                             const std::uint64_t offset) {
+  for (int i = 0; i < count; ++i) {
+    if (!isAligned(iov[i].iov_base, iov[i].iov_len, offset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DirectFileIO::readBlocks(char *buffer, const std::size_t size,
+                              const std::uint64_t offset) {
+  ssize_t count;
+  do {
+    count = ::pread(fd_, buffer, size, static_cast<off_t>(offset));
+  } while (count < 0 && errno == EINTR);
+  if (count < 0) {
+    throw FileIOException(filename_, "read", errno);
+  }
+  // Direct reads only come up short at the end of the file.
+  std::memset(buffer + count, 0, size - count);
+}
+
+void DirectFileIO::read(char *buffer, const std::size_t size,
+                        const std::uint64_t offset) {
+  if (isAligned(buffer, size, offset)) {
+    readBlocks(buffer, size, offset);
+    return;
+  }
+  const std::uint64_t start = offset / ALIGNMENT * ALIGNMENT;
+  const std::uint64_t end =
+      (offset + size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  AlignedBuffer staging(end - start);
+  readBlocks(staging.data(), staging.size(), start);
+  std::memcpy(buffer, staging.data() + (offset - start), size);
+}
+
+void DirectFileIO::write(const char *buffer, const std::size_t size,
+                         const std::uint64_t offset) {
+  if (isAligned(buffer, size, offset)) {
+    PosixFileIO::write(buffer, size, offset);
+    return;
+  }
+  const std::uint64_t start = offset / ALIGNMENT * ALIGNMENT;
+  const std::uint64_t end =
+      (offset + size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  AlignedBuffer staging(end - start);
+  if (start != offset || end != offset + size) {
+    // Keep the rest of the blocks the request partially covers.
+    readBlocks(staging.data(), staging.size(), start);
+  }
+  std::memcpy(staging.data() + (offset - start), buffer, size);
+  PosixFileIO::write(staging.data(), staging.size(), start);
+}
+
+void DirectFileIO::readv(const iovec *iov, const int count,
+                         const std::uint64_t offset) {
+  if (isAligned(iov, count, offset)) {
+    PosixFileIO::readv(iov, count, offset);
+  } else {
+    FileIO::readv(iov, count, offset);
+  }
+}
+
+void DirectFileIO::writev(const iovec *iov, const int count,
+                          const std::uint64_t offset) {
+  if (isAligned(iov, count, offset)) {
+    PosixFileIO::writev(iov, count, offset);
+  } else {
+    FileIO::writev(iov, count, offset);
+  }
+}
+
+const std::uint64_t MmapFileIO::MIN_MAPPING;
+
+MmapFileIO::MmapFileIO(const std::string &filename, const bool create_new)
+    : PosixFileIO(filename, create_new),
+      data_(nullptr),
+      pattern_(AccessPattern::NORMAL),
+      size_(PosixFileIO::size()) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  mapAtLeast(size_);
+}
+
+MmapFileIO::Mapping::~Mapping() {
+  ::munmap(const_cast<char *>(data), length);
+}
+
+std::shared_ptr<const MmapFileIO::Mapping> MmapFileIO::mapping() const {
+  return std::atomic_load(&mapping_);
+}
+
+void MmapFileIO::mapAtLeast(const std::uint64_t end) {
+  if (mapping_ && mapping_->length >= end) return;
+  // Leave room to grow to twice the size before mapping again.
+  const std::uint64_t length = std::max(2 * end, MIN_MAPPING);
+  void *data = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    throw FileIOException(filename_, "map", errno);
+  }
+  ::madvise(data, length, memoryAdvice(pattern_));
+  std::shared_ptr<const Mapping> mapped = std::make_shared<const Mapping>(
+      static_cast<const char *>(data), length);
+  if (mapping_) retired_.push_back(mapping_);
+  std::atomic_store(&mapping_, mapped);
+  data_.store(mapped->data, std::memory_order_release);
+}
+
+void MmapFileIO::read(char *buffer, const std::size_t size,
+                      const std::uint64_t offset) {
+  // Load the size first: the mapping is replaced before the size grows.
+  if (offset + size <= size_) {
+    std::memcpy(buffer, data_.load(std::memory_order_acquire) + offset, size);
+    return;
+  }
+  // Past the end of the file, which pread() zero-fills.
+  PosixFileIO::read(buffer, size, offset);
+}
+
+void MmapFileIO::readv(const iovec *iov, const int count,
+                       const std::uint64_t offset) {
+  std::uint64_t position = offset;
+  for (int i = 0; i < count; ++i) {
+    read(static_cast<char *>(iov[i].iov_base), iov[i].iov_len, position);
+    position += iov[i].iov_len;
+  }
+}
+
+void MmapFileIO::write(const char *buffer, const std::size_t size,
+                       const std::uint64_t offset) {
+  PosixFileIO::write(buffer, size, offset);
+  grown(offset + size);
+}
+
+void MmapFileIO::writev(const iovec *iov, const int count,
+                        const std::uint64_t offset) {
+  PosixFileIO::writev(iov, count, offset);
+  std::uint64_t end = offset;
+  for (int i = 0; i < count; ++i) {
+    end += iov[i].iov_len;
+  }
+  grown(end);
+}
+
+void MmapFileIO::grown(const std::uint64_t end) {
+  if (end <= size_) return;
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (end <= size_) return;
+  mapAtLeast(end);
+  size_ = end;
+}
+
+const char *MmapFileIO::view(const std::size_t size,
+                             const std::uint64_t offset,
+                             std::shared_ptr<const void> &owner) {
+  if (offset + size > size_) return nullptr;
+  std::shared_ptr<const Mapping> current = mapping();
+  owner = current;
+  return current->data + offset;
+}
+
+void MmapFileIO::advise(const AccessPattern pattern) {
+  PosixFileIO::advise(pattern);
+  std::lock_guard<std::mutex> guard(mutex_);
+  pattern_ = pattern;
+  ::madvise(const_cast<char *>(mapping_->data), mapping_->length,
+            memoryAdvice(pattern));
+}
+
+StreamFileIO::StreamFileIO(const std::string &filename, const bool create_new)
+    : FileIO(filename) {
+  std::ios_base::openmode mode =
+      std::fstream::in | std::fstream::out | std::fstream::binary;
+  if (create_new) {
+    mode = mode | std::fstream::trunc;
+  }
+  stream_.open(filename, mode);
+  if (!stream_) {
+    throw FileIOException(filename_, "open", errno);
+  }
+}
+
+void StreamFileIO::read(char *buffer, const std::size_t size,
+                        const std::uint64_t offset) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  stream_.seekg(offset, std::ios::beg);
+  stream_.read(buffer, size);
+  const std::size_t done = stream_.gcount();
+  if (done < size) {
+    // End of file; reset the stream's eof and fail bits.
+    stream_.clear();
+    std::memset(buffer + done, 0, size - done);
+  }
+}
+
+void StreamFileIO::write(const char *buffer, const std::size_t size,
+                         const std::uint64_t offset) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  stream_.seekp(offset, std::ios::beg);
+  stream_.write(buffer, size);
+  if (!stream_) {
+    stream_.clear();
+    throw FileIOException(filename_, "write", errno);
+  }
+}
+
+std::uint64_t StreamFileIO::size() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  stream_.seekg(0, std::ios::end);
+  const std::streamoff end = stream_.tellg();
+  if (end < 0) {
+    stream_.clear();
+    throw FileIOException(filename_, "stat", errno);
+  }
+  return end;
+}
+
+void StreamFileIO::flush() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  stream_.flush();
+  if (!stream_) {
+    stream_.clear();
+    throw FileIOException(filename_, "flush", errno);
+  }
+}
+
+void StreamFileIO::sync(const bool data_only) {
+  flush();
+  // Syncing any descriptor of a file forces all of its written data.
+  const int fd = ::open(filename_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw FileIOException(filename_, "sync", errno);
+  }
+  const int error = syncDescriptor(fd, data_only);
+  ::close(fd);
+  if (error != 0) {
+    throw FileIOException(filename_, "sync", error);
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,574 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Ways a File can do I/O on its underlying file.
+ */
+enum class FileBackend {
+  /**
+   * pread()/pwrite() on a file descriptor.  Requests never wait for each
+   * other.
+   */
+  POSIX,
+
+  /**
+   * An std::fstream, on which every request seeks first.  Requests are
+   * serialized.
+   */
+  STREAM,
+
+  /**
+   * pread()/pwrite() on a file descriptor opened with O_DIRECT, bypassing the
+   * operating system's page cache so that pages are cached only once, in the
+   * buffer pool.  Only for files with the aligned page layout.
+   */
+  DIRECT,
+
+  /**
+   * Reads are copied out of a shared read-only mapping of the file, without a
+   * system call, and File::viewPage() exposes pages in place.  Writes go
+   * through pwrite().  Meant for read-mostly files.
+   */
+  MMAP,
+};
+
+/**
+ * @brief Expected pattern of accesses to a file, passed on to the operating
+ * system as a hint.
+ */
+enum class AccessPattern {
+  NORMAL,
+  RANDOM,
+  SEQUENTIAL,
+};
+
+/**
+ * @brief How durable File::sync() makes what has been written to a file.
+ */
+enum class SyncPolicy {
+  /**
+   * Nothing is done; for temporary files.
+   */
+  NONE,
+
+  /**
+   * Writes are handed to the operating system, so that they survive a crash
+   * of the process but not of the machine.
+   */
+  FLUSH,
+
+  /**
+   * Written data is forced to the device with fdatasync(), skipping metadata
+   * not needed to read it back, such as modification times.
+   */
+  DATASYNC,
+
+  /**
+   * Written data and all metadata are forced to the device with fsync().
+   */
+  FSYNC,
+};
+
+/**
+ * @brief Heap buffer aligned for direct I/O.
+ */
+class AlignedBuffer {
+ public:
+  /**
+   * Allocates size bytes aligned to FileIO::ALIGNMENT.
+   */
+  explicit AlignedBuffer(const std::size_t size);
+
+  char *data() const { return data_.get(); }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  struct Free {
+    void operator()(char *data) const;
+  };
+
+  std::unique_ptr<char, Free> data_;
+  std::size_t size_;
+};
+
+/**
+ * @brief Positional reads and writes on an open file.
+ *
+ * One FileIO is shared by all File objects for the same underlying file, and
+ * its methods may be called concurrently.  Reads that extend past the end of
+ * the file fill the rest of the buffer with zeros.
+ */
+class FileIO {
+ public:
+  /**
+   * Alignment of memory, file offsets and lengths that direct I/O requires.
+   * Buffers and requests aligned this way are never copied.
+   */
+  static const std::size_t ALIGNMENT = 4096;
+
+  /**
+   * Opens a file with the given backend.
+   *
+   * @param backend     Backend to use.
+   * @param filename    Name of the file.
+   * @param create_new  Whether to create the file, truncating it if it exists.
+   * @return  The opened file.
+   * @throws  FileIOException   If the file cannot be opened.
+   */
+  static std::unique_ptr<FileIO> open(const FileBackend backend,
+                                      const std::string &filename,
+                                      const bool create_new);
+
+  /**
+   * Renames a file over another, replacing it atomically, and syncs the
+   * directory holding them so that the rename itself survives a crash.
+   *
+   * @param from  Name of the file to rename.
+   * @param to    Name to give it; any file already there is replaced.
+   * @throws  FileIOException   If the rename or the sync fails.
+   */
+  static void replace(const std::string &from, const std::string &to);
+
+  /**
+   * Cuts a file that is not open down to the given size.
+   *
+   * @param filename  Name of the file.
+   * @param size      New size of the file, in bytes.
+   * @throws  FileIOException   If the truncation fails.
+   */
+  static void truncate(const std::string &filename, const std::uint64_t size);
+
+  virtual ~FileIO() {}
+
+  /**
+   * Reads size bytes at offset into buffer.
+   *
+   * @throws  FileIOException   If the read fails.
+   */
+  virtual void read(char *buffer, const std::size_t size,
+                    const std::uint64_t offset) = 0;
+
+  /**
+   * Reads the bytes at offset into the count buffers of iov, filling each in
+   * turn.  The default reads a single buffer with read(), and several into a
+   * staging buffer that it copies out; backends that can scatter a read do
+   * so without copying.
+   *
+   * @throws  FileIOException   If the read fails.
+   */
+  virtual void readv(const iovec *iov, const int count,
+                     const std::uint64_t offset);
+
+  /**
+   * Writes size bytes from buffer at offset.
+   *
+   * @throws  FileIOException   If the write fails.
+   */
+  virtual void write(const char *buffer, const std::size_t size,
+                     const std::uint64_t offset) = 0;
+
+  /**
+   * Writes the count buffers of iov, one after the other, at offset.  The
+   * default writes a single buffer with write(), and gathers several into a
+   * staging buffer first; backends that can gather a write do so without
+   * copying.
+   *
+   * @throws  FileIOException   If the write fails.
+   */
+  virtual void writev(const iovec *iov, const int count,
+                      const std::uint64_t offset);
+
+  /**
+   * Hands writes buffered in user space over to the operating system.
+   *
+   * @throws  FileIOException   If the writes fail.
+   */
+  virtual void flush() = 0;
+
+  /**
+   * Forces the writes handed to the operating system to the device.
+   *
+   * @param data_only   Whether to skip metadata not needed to read the data
+   *                    back (fdatasync() rather than fsync()).
+   * @throws  FileIOException   If the writes fail.
+   */
+  virtual void sync(const bool data_only) = 0;
+
+  /**
+   * Returns the current size of the file in bytes.
+   *
+   * @throws  FileIOException   If the size cannot be determined.
+   */
+  virtual std::uint64_t size() = 0;
+
+  /**
+   * Returns a file descriptor on which the given request can be issued as
+   * is, e.g. by an IOEngine, or -1 if it has to go through read() or
+   * write().
+   */
+  virtual int descriptorFor(const void *buffer, const std::size_t size,
+                            const std::uint64_t offset) const {
+    return -1;
+  }
+
+  /**
+   * Returns the size bytes at offset in place, or null if the backend cannot
+   * expose them (or they lie past the end of the file).  The bytes stay
+   * readable for as long as owner is held, and show later writes to them.
+   *
+   * @param size    Number of bytes.
+   * @param offset  Offset of the bytes in the file.
+   * @param owner   Set to the object keeping the bytes readable.
+   */
+  virtual const char *view(const std::size_t size, const std::uint64_t offset,
+                           std::shared_ptr<const void> &owner) {
+    return nullptr;
+  }
+
+  /**
+   * Tells the operating system how the file is going to be accessed.
+   */
+  virtual void advise(const AccessPattern pattern) {}
+
+  /**
+   * Reserves disk space for the size bytes at offset, so that writing them
+   * cannot run out of space and they are laid out contiguously where the
+   * filesystem can.  Does not change size().  Backends that cannot reserve
+   * space do nothing.
+   *
+   * @throws  FileIOException   If there is not enough space.
+   */
+  virtual void allocate(const std::uint64_t offset, const std::uint64_t size) {
+  }
+
+ protected:
+  explicit FileIO(const std::string &filename) : filename_(filename) {}
+
+  /**
+   * Name of the file, for error messages.
+   */
+  const std::string filename_;
+};
+
+/**
+ * @brief FileIO doing pread()/pwrite() on a file descriptor.
+ *
+ * Writes go straight to the operating system, so flush() does nothing.
+ */
+class PosixFileIO : public FileIO {
+ public:
+  /**
+   * Opens the file.
+   *
+   * @param filename    Name of the file.
+   * @param create_new  Whether to create the file, truncating it if it exists.
+   * @throws  FileIOException   If the file cannot be opened.
+   */
+  PosixFileIO(const std::string &filename, const bool create_new);
+
+  ~PosixFileIO() override;
+
+  void read(char *buffer, const std::size_t size,
+            const std::uint64_t offset) override;
+
+  /**
+   * Reads with preadv(), IOV_MAX buffers per call.
+   */
+  void readv(const iovec *iov, const int count,
+             const std::uint64_t offset) override;
+
+  void write(const char *buffer, const std::size_t size,
+             const std::uint64_t offset) override;
+
+  /**
+   * Writes with pwritev(), IOV_MAX buffers per call.
+   */
+  void writev(const iovec *iov, const int count,
+              const std::uint64_t offset) override;
+
+  void flush() override {}
+
+  void sync(const bool data_only) override;
+
+  std::uint64_t size() override;
+
+  int descriptorFor(const void *buffer, const std::size_t size,
+                    const std::uint64_t offset) const override {
+    return fd_;
+  }
+
+  void advise(const AccessPattern pattern) override;
+
+  void allocate(const std::uint64_t offset, const std::uint64_t size) override;
+
+ protected:
+  /**
+   * Opens the file with the given open() flags in addition to the usual ones.
+   */
+  PosixFileIO(const std::string &filename, const bool create_new,
+              const int flags);
+
+  /**
+   * Descriptor of the open file.
+   */
+  int fd_;
+};
+
+/**
+ * @brief FileIO doing pread()/pwrite() on a file descriptor opened with
+ * O_DIRECT.
+ *
+ * Requests whose memory, offset and length are all aligned to ALIGNMENT go to
+ * the device as they are.  Others are widened to aligned blocks and staged in
+ * an aligned buffer; an unaligned write thus reads the blocks it partially
+ * covers first, so unaligned writes to the same block must not run
+ * concurrently (File serializes all writes).
+ */
+class DirectFileIO : public PosixFileIO {
+ public:
+  /**
+   * Opens the file.
+   *
+   * @param filename    Name of the file.
+   * @param create_new  Whether to create the file, truncating it if it exists.
+   * @throws  FileIOException   If the file cannot be opened, e.g. because the
+   *                            file system does not support O_DIRECT.
+   */
+  DirectFileIO(const std::string &filename, const bool create_new);
+
+  void read(char *buffer, const std::size_t size,
+            const std::uint64_t offset) override;
+
+  /**
+   * Scatters the read with preadv() if every buffer is aligned, such as a
+   * run of Pages; stages it otherwise.
+   */
+  void readv(const iovec *iov, const int count,
+             const std::uint64_t offset) override;
+
+  void write(const char *buffer, const std::size_t size,
+             const std::uint64_t offset) override;
+
+  /**
+   * Gathers the write with pwritev() if every buffer is aligned; stages it
+   * otherwise.
+   */
+  void writev(const iovec *iov, const int count,
+              const std::uint64_t offset) override;
+
+  int descriptorFor(const void *buffer, const std::size_t size,
+                    const std::uint64_t offset) const override {
+    return isAligned(buffer, size, offset) ? fd_ : -1;
+  }
+
+ private:
+  /**
+   * Returns whether a request can be issued without staging.
+   */
+  static bool isAligned(const void *buffer, const std::size_t size,
+                        const std::uint64_t offset);
+
+  /**
+   * Returns whether a vectored request can be issued without staging.
+   */
+  static bool isAligned(const iovec *iov, const int count,
+                        const std::uint64_t offset);
+
+  /**
+   * Reads aligned blocks, filling the part past the end of the file with
+   * zeros.
+   */
+  void readBlocks(char *buffer, const std::size_t size,
+                  const std::uint64_t offset);
+};
+
+/**
+ * @brief FileIO reading from a shared read-only mapping of the file.
+ *
+ * The mapping reaches past the end of the file, so that the file can grow
+ * through write() for a while before it has to be mapped again.  Remapping
+ * creates a new mapping, and only remapping takes a lock: reads find the
+ * current mapping through atomics.  Writes go through pwrite(), which the
+ * mapping shows since both share the page cache.
+ */
+class MmapFileIO : public PosixFileIO {
+ public:
+  /**
+   * Smallest length mapped, so that small files can grow without remapping.
+   */
+  static const std::uint64_t MIN_MAPPING = 1 << 20;
+
+  /**
+   * Opens and maps the file.
+   *
+   * @param filename    Name of the file.
+   * @param create_new  Whether to create the file, truncating it if it exists.
+   * @throws  FileIOException   If the file cannot be opened or mapped.
+   */
+  MmapFileIO(const std::string &filename, const bool create_new);
+
+  void read(char *buffer, const std::size_t size,
+            const std::uint64_t offset) override;
+
+  /**
+   * Copies each buffer straight from the mapping.
+   */
+  void readv(const iovec *iov, const int count,
+             const std::uint64_t offset) override;
+
+  void write(const char *buffer, const std::size_t size,
+             const std::uint64_t offset) override;
+
+  void writev(const iovec *iov, const int count,
+              const std::uint64_t offset) override;
+
+  std::uint64_t size() override { return size_; }
+
+  /**
+   * Returns -1 for every request: a write issued on the descriptor directly
+   * could grow the file without remapping it, and reads copy out of the
+   * mapping anyway.
+   */
+  int descriptorFor(const void *buffer, const std::size_t size,
+                    const std::uint64_t offset) const override {
+    return -1;
+  }
+
+  const char *view(const std::size_t size, const std::uint64_t offset,
+                   std::shared_ptr<const void> &owner) override;
+
+  void advise(const AccessPattern pattern) override;
+
+ private:
+  /**
+   * @brief A mapping of the file, unmapped when the last holder lets go.
+   */
+  struct Mapping {
+    Mapping(const char *data, const std::uint64_t length)
+        : data(data), length(length) {}
+
+    ~Mapping();
+
+    const char *data;
+    std::uint64_t length;
+  };
+
+  /**
+   * Returns the current mapping, without taking mutex_.
+   */
+  std::shared_ptr<const Mapping> mapping() const;
+
+  /**
+   * Maps the file again if the first end bytes are not all mapped.  Called
+   * with mutex_ held.
+   */
+  void mapAtLeast(const std::uint64_t end);
+
+  /**
+   * Notes that a write reached end, mapping the file again if it grew past
+   * the mapping.
+   */
+  void grown(const std::uint64_t end);
+
+  /**
+   * Current mapping.  Replaced with std::atomic_store() under mutex_ and
+   * read with std::atomic_load(), except by holders of mutex_.
+   */
+  std::shared_ptr<const Mapping> mapping_;
+
+  /**
+   * Start of the current mapping, for read(), which copies out of it without
+   * even taking a reference.
+   */
+  std::atomic<const char *> data_;
+
+  /**
+   * Mappings replaced by a remap, kept until the file is closed because
+   * read() may still be copying out of them.  As each mapping is twice as
+   * long as the last, they take less address space than the current one.
+   * Guarded by mutex_.
+   */
+  std::vector<std::shared_ptr<const Mapping>> retired_;
+
+  /**
+   * Access pattern last advised, applied to new mappings too.  Guarded by
+   * mutex_.
+   */
+  AccessPattern pattern_;
+
+  /**
+   * Size of the file; every byte below it is mapped.
+   */
+  std::atomic<std::uint64_t> size_;
+
+  /**
+   * Guards changes to mapping_, pattern_ and retired_, and serializes
+   * growth.
+   */
+  mutable std::mutex mutex_;
+};
+
+/**
+ * @brief FileIO on an std::fstream, serialized by a mutex.
+ */
+class StreamFileIO : public FileIO {
+ public:
+  /**
+   * Opens the file.
+   *
+   * @param filename    Name of the file.
+   * @param create_new  Whether to create the file, truncating it if it exists.
+   * @throws  FileIOException   If the file cannot be opened.
+   */
+  StreamFileIO(const std::string &filename, const bool create_new);
+
+  void read(char *buffer, const std::size_t size,
+            const std::uint64_t offset) override;
+
+  void write(const char *buffer, const std::size_t size,
+             const std::uint64_t offset) override;
+
+  void flush() override;
+
+  /**
+   * Flushes the stream and forces the file to the device through a
+   * descriptor of its own, since an std::fstream exposes none.
+   */
+  void sync(const bool data_only) override;
+
+  std::uint64_t size() override;
+
+ private:
+  /**
+   * Stream for the file.
+   */
+  std::fstream stream_;
+
+  /**
+   * Serializes use of stream_, whose position is shared by all requests.
+   */
+  std::mutex mutex_;
+};
+
+}  // namespace badgerdb
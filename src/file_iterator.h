@@ -37,8 +37,7 @@ class FileIterator {
    */
   FileIterator(File *file) : file_(file) {
     assert(file_ != NULL);
-    const FileHeader &header = file_->readHeader();
-    current_page_number_ = header.first_used_page;
+    current_page_number_ = file_->nextUsedPage(Page::INVALID_NUMBER);
   }
 
   /**
@@ -52,12 +51,12 @@ class FileIterator {
       : file_(file), current_page_number_(page_number) {}
 
   /**
-   * Advances the iterator to the next page in the file.
+   * Advances the iterator to the next used page in the file, looked up in its
+   * PageDirectory without reading any page.
    */
   inline FileIterator &operator++() {
     assert(file_ != NULL);
-    const PageHeader &header = file_->readPageHeader(current_page_number_);
-    current_page_number_ = header.next_page_number;
+    current_page_number_ = file_->nextUsedPage(current_page_number_);
 
     return *this;
   }
@@ -67,8 +66,7 @@ class FileIterator {
     FileIterator tmp = *this;  // copy ourselves
 
     assert(file_ != NULL);
-    const PageHeader &header = file_->readPageHeader(current_page_number_);
-    current_page_number_ = header.next_page_number;
+    current_page_number_ = file_->nextUsedPage(current_page_number_);
 
     return tmp;
   }
@@ -80,12 +78,12 @@ class FileIterator {
    * @return    True if other iterator is equal to this one.
    */
   inline bool operator==(const FileIterator &rhs) const {
-    return file_->filename() == rhs.file_->filename() &&
+    return file_->id() == rhs.file_->id() &&
            current_page_number_ == rhs.current_page_number_;
   }
 
   inline bool operator!=(const FileIterator &rhs) const {
-    return (file_->filename() != rhs.file_->filename()) ||
+    return (file_->id() != rhs.file_->id()) ||
            (current_page_number_ != rhs.current_page_number_);
   }
 
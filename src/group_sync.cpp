@@ -0,0 +1,47 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "group_sync.h"
+
+namespace badgerdb {
+
+void GroupSync::sync(const std::function<void()> &operation) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const std::uint64_t ticket = ++requested_;
+  while (true) {
+    // A run in progress may have started before this call.
+    done_.wait(lock, [this] { return !running_; });
+    if (completed_ >= ticket) {
+      return;
+    }
+    // Lead a run covering every call so far.
+    running_ = true;
+    const std::uint64_t covered = requested_;
+    ++runs_;
+    lock.unlock();
+    try {
+      operation();
+    } catch (...) {
+      lock.lock();
+      running_ = false;
+      done_.notify_all();
+      throw;
+    }
+    lock.lock();
+    running_ = false;
+    completed_ = covered;
+    done_.notify_all();
+  }
+}
+
+std::uint64_t GroupSync::runs() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return runs_;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,76 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace badgerdb {
+
+/**
+ * @brief Lets concurrent callers share runs of a sync operation, e.g. an
+ * fsync().
+ *
+ * A caller of sync() needs a run of the operation that starts after the call
+ * does.  If one is in progress, the caller waits for it to end, and then
+ * either a run started meanwhile by another waiter covers it, or it runs the
+ * operation itself on behalf of everyone who arrived while it waited.  Under
+ * load, a single run thus serves a whole group of callers.
+ */
+class GroupSync {
+ public:
+  GroupSync() : requested_(0), completed_(0), running_(false), runs_(0) {}
+
+  /**
+   * Returns once a run of operation that started after this call has
+   * completed.
+   *
+   * @param operation   The sync operation; the same for every caller.
+   * @throws  Whatever the run of operation made on behalf of this caller
+   *          threw; waiters covered by a failed run try again.
+   */
+  void sync(const std::function<void()> &operation);
+
+  /**
+   * Returns the number of runs of the operation so far.
+   */
+  std::uint64_t runs() const;
+
+ private:
+  mutable std::mutex mutex_;
+
+  /**
+   * Signalled when a run ends.
+   */
+  std::condition_variable done_;
+
+  /**
+   * Number of sync() calls so far; each call's ticket.
+   */
+  std::uint64_t requested_;
+
+  /**
+   * Tickets up to this one are covered by a completed run.
+   */
+  std::uint64_t completed_;
+
+  /**
+   * Whether a run is in progress.
+   */
+  bool running_;
+
+  /**
+   * Number of runs so far.
+   */
+  std::uint64_t runs_;
+};
+
+}  // namespace badgerdb
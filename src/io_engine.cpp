@@ -0,0 +1,334 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "io_engine.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "exceptions/file_io_exception.h"
+
+namespace badgerdb {
+
+const unsigned IOEngine::DEFAULT_DEPTH;
+
+std::unique_ptr<IOEngine> IOEngine::create(const IOEngineType type,
+                                           const unsigned depth) {
+  if (type == IOEngineType::IO_URING) {
+    try {
+      return std::unique_ptr<IOEngine>(new IOUringEngine(depth));
+    } catch (const FileIOException &) {
+      // No io_uring in this kernel (or it is disallowed); run synchronously.
+    }
+  }
+  return std::unique_ptr<IOEngine>(new SyncIOEngine());
+}
+
+void IOEngine::queueRead(FileIO &io, char *buffer, const std::size_t size,
+                         const std::uint64_t offset, Callback done) {
+  queued_.push_back({&io, buffer, size, offset, false /* write */,
+                     std::move(done)});
+}
+
+void IOEngine::queueWrite(FileIO &io, const char *buffer,
+                          const std::size_t size, const std::uint64_t offset,
+                          Callback done) {
+  // The buffer is only ever handed to write requests.
+  queued_.push_back({&io, const_cast<char *>(buffer), size, offset,
+                     true /* write */, std::move(done)});
+}
+
+void IOEngine::queueWritev(FileIO &io, const iovec *iov, const int count,
+                           const std::uint64_t offset, Callback done) {
+  std::size_t size = 0;
+  for (int i = 0; i < count; ++i) {
+    size += iov[i].iov_len;
+  }
+  queued_.push_back({&io, nullptr, size, offset, true /* write */,
+                     std::move(done), std::vector<iovec>(iov, iov + count)});
+}
+
+std::size_t IOEngine::wait() {
+  const std::size_t before = completed_;
+  while (pending() > 0) {
+    submit();
+    if (inFlight() > 0) reap(true /* block */);
+  }
+  return completed_ - before;
+}
+
+std::size_t IOEngine::poll() {
+  const std::size_t before = completed_;
+  reap(false /* block */);
+  return completed_ - before;
+}
+
+void IOEngine::runSync(Request &request) {
+  int error = 0;
+  try {
+    if (!request.iov.empty()) {
+      request.io->writev(request.iov.data(),
+                         static_cast<int>(request.iov.size()), request.offset);
+    } else if (request.write) {
+      request.io->write(request.buffer, request.size, request.offset);
+    } else {
+      request.io->read(request.buffer, request.size, request.offset);
+    }
+  } catch (const FileIOException &e) {
+    error = e.error();
+  }
+  finish(request, error);
+}
+
+void IOEngine::finish(Request &request, const int error) {
+  ++completed_;
+  request.done(error);
+}
+
+std::size_t SyncIOEngine::submit() {
+  std::size_t submitted = 0;
+  while (!queued_.empty()) {
+    Request request = std::move(queued_.front());
+    queued_.pop_front();
+    runSync(request);
+    ++submitted;
+  }
+  return submitted;
+}
+
+IOUringEngine::IOUringEngine(const unsigned depth)
+    : sq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      cq_ring_(MAP_FAILED),
+      cq_ring_size_(0),
+      sqes_(MAP_FAILED),
+      sqes_size_(0) {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(
+      ::syscall(__NR_io_uring_setup, std::max(depth, 1u), &params));
+  if (ring_fd_ < 0) {
+    throw FileIOException("io_uring", "setup", errno);
+  }
+  if (!supportsReadWrite()) {
+    release();
+    throw FileIOException("io_uring", "probe", EOPNOTSUPP);
+  }
+  depth_ = params.sq_entries;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ != MAP_FAILED) {
+    cq_ring_ = single_mmap ? sq_ring_
+                           : ::mmap(nullptr, cq_ring_size_,
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                    IORING_OFF_CQ_RING);
+  }
+  if (cq_ring_ != MAP_FAILED) {
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  }
+  if (sqes_ == MAP_FAILED) {
+    const int error = errno;
+    release();
+    throw FileIOException("io_uring", "map", error);
+  }
+
+  char *sq = static_cast<char *>(sq_ring_);
+  char *cq = static_cast<char *>(cq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+
+  // The completion queue holds at least as many entries as the submission
+  // queue, so keeping at most depth_ requests in flight never overflows it.
+  slots_.resize(depth_);
+  for (std::uint32_t slot = depth_; slot > 0; --slot) {
+    free_slots_.push_back(slot - 1);
+  }
+}
+
+IOUringEngine::~IOUringEngine() {
+  // Requests in flight still write into their buffers; finish them first.
+  try {
+    while (inFlight() > 0) reap(true /* block */);
+  } catch (const FileIOException &) {
+  }
+  release();
+}
+
+bool IOUringEngine::supportsReadWrite() const {
+  // io_uring_probe ends in a flexible array of entries, one per opcode.
+  const unsigned num_ops = 256;
+  std::vector<char> buffer(sizeof(io_uring_probe) +
+                           num_ops * sizeof(io_uring_probe_op));
+  io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+  if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, probe,
+                num_ops) < 0) {
+    return false;
+  }
+  for (const unsigned op :
+       {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_WRITEV}) {
+    if (op > probe->last_op ||
+        !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void IOUringEngine::release() {
+  if (sqes_ != MAP_FAILED) ::munmap(sqes_, sqes_size_);
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) ::munmap(sq_ring_, sq_ring_size_);
+  ::close(ring_fd_);
+}
+
+std::size_t IOUringEngine::submit() {
+  std::size_t submitted = 0;
+  unsigned to_submit = 0;
+  unsigned tail = *sq_tail_;
+  while (!queued_.empty() && !free_slots_.empty()) {
+    Request request = std::move(queued_.front());
+    queued_.pop_front();
+    ++submitted;
+    const int fd = descriptorFor(request);
+    if (fd < 0) {
+      runSync(request);
+      continue;
+    }
+
+    const std::uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    const unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = fd;
+    if (!request.iov.empty()) {
+      sqe->opcode = IORING_OP_WRITEV;
+      sqe->addr = reinterpret_cast<std::uint64_t>(request.iov.data());
+      sqe->len = static_cast<std::uint32_t>(request.iov.size());
+    } else {
+      sqe->opcode = request.write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->addr = reinterpret_cast<std::uint64_t>(request.buffer);
+      sqe->len = static_cast<std::uint32_t>(request.size);
+    }
+    sqe->off = request.offset;
+    sqe->user_data = slot;
+    sq_array_[index] = index;
+    slots_[slot] = std::move(request);
+    ++tail;
+    ++to_submit;
+  }
+  if (to_submit == 0) return submitted;
+
+  // Publish the entries before the kernel reads the tail.
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+  while (to_submit > 0) {
+    const long entered = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                                   0 /* min_complete */, 0 /* flags */,
+                                   nullptr, 0);
+    if (entered < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      throw FileIOException("io_uring", "submit", errno);
+    }
+    to_submit -= static_cast<unsigned>(entered);
+  }
+  return submitted;
+}
+
+void IOUringEngine::reap(const bool block) {
+  if (block) {
+    while (::syscall(__NR_io_uring_enter, ring_fd_, 0 /* to_submit */,
+                     1 /* min_complete */, IORING_ENTER_GETEVENTS, nullptr,
+                     0) < 0) {
+      if (errno != EINTR) throw FileIOException("io_uring", "wait", errno);
+    }
+  }
+  unsigned head = *cq_head_;
+  while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+    const io_uring_cqe *cqe =
+        static_cast<const io_uring_cqe *>(cqes_) + (head & *cq_mask_);
+    const std::uint32_t slot = static_cast<std::uint32_t>(cqe->user_data);
+    const int result = cqe->res;
+    // Hand the entry back before the callback, which may submit more.
+    __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+    complete(slot, result);
+  }
+}
+
+void IOUringEngine::complete(const std::uint32_t slot, const int result) {
+  Request request = std::move(slots_[slot]);
+  free_slots_.push_back(slot);
+  if (result < 0) {
+    finish(request, -result);
+    return;
+  }
+  const std::size_t done = static_cast<std::size_t>(result);
+  if (done < request.size) {
+    // Short transfer, at the end of the file for a read: finish the rest
+    // synchronously, which zero-fills what lies past the end.
+    request.size -= done;
+    request.offset += done;
+    if (request.iov.empty()) {
+      request.buffer += done;
+    } else {
+      std::size_t skipped = done;
+      auto first = request.iov.begin();
+      while (skipped >= first->iov_len) {
+        skipped -= first->iov_len;
+        ++first;
+      }
+      first->iov_base = static_cast<char *>(first->iov_base) + skipped;
+      first->iov_len -= skipped;
+      request.iov.erase(request.iov.begin(), first);
+    }
+    runSync(request);
+    return;
+  }
+  finish(request, 0);
+}
+
+int IOUringEngine::descriptorFor(const Request &request) {
+  if (request.iov.empty()) {
+    return request.io->descriptorFor(request.buffer, request.size,
+                                     request.offset);
+  }
+  int fd = -1;
+  std::uint64_t offset = request.offset;
+  for (const iovec &buffer : request.iov) {
+    fd = request.io->descriptorFor(buffer.iov_base, buffer.iov_len, offset);
+    if (fd < 0) return -1;
+    offset += buffer.iov_len;
+  }
+  return fd;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,297 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "file_io.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Kinds of IOEngine.
+ */
+enum class IOEngineType {
+  /**
+   * Linux io_uring: queued requests are submitted with one system call and
+   * run concurrently.  Falls back to SYNC if the kernel does not provide it.
+   */
+  IO_URING,
+
+  /**
+   * Queued requests are run one at a time, through FileIO::read() and
+   * FileIO::write(), when they are submitted.
+   */
+  SYNC,
+};
+
+/**
+ * @brief Queue of asynchronous reads and writes on FileIO objects.
+ *
+ * Requests are queued, handed to the operating system in batches by submit(),
+ * and completed by wait() or poll(), which run each request's callback in the
+ * calling thread.  Reads past the end of the file are filled with zeros, as
+ * with FileIO::read().  The buffers of a request must stay valid until its
+ * callback has run, and callbacks must not throw; they may queue further
+ * requests.
+ *
+ * An IOEngine is not thread-safe; each thread needs its own or a latch around
+ * it.
+ */
+class IOEngine {
+ public:
+  /**
+   * Called when a request completes, with 0 or the errno value reported for
+   * its failure.
+   */
+  typedef std::function<void(int error)> Callback;
+
+  /**
+   * Default number of requests in flight at once.
+   */
+  static const unsigned DEFAULT_DEPTH = 64;
+
+  /**
+   * Creates an engine.
+   *
+   * @param type    Kind of engine wanted.
+   * @param depth   Maximum number of requests in flight at once.
+   * @return  The engine; a SYNC one if io_uring was wanted but is not
+   *          available.
+   */
+  static std::unique_ptr<IOEngine> create(
+      const IOEngineType type = IOEngineType::IO_URING,
+      const unsigned depth = DEFAULT_DEPTH);
+
+  IOEngine() : completed_(0) {}
+
+  virtual ~IOEngine() {}
+
+  /**
+   * Queues a read of size bytes at offset into buffer.
+   */
+  void queueRead(FileIO &io, char *buffer, const std::size_t size,
+                 const std::uint64_t offset, Callback done);
+
+  /**
+   * Queues a write of size bytes from buffer at offset.
+   */
+  void queueWrite(FileIO &io, const char *buffer, const std::size_t size,
+                  const std::uint64_t offset, Callback done);
+
+  /**
+   * Queues a write of count buffers, gathered, at offset.  The iovecs are
+   * copied; the buffers they point to must stay valid until done is called.
+   */
+  void queueWritev(FileIO &io, const iovec *iov, const int count,
+                   const std::uint64_t offset, Callback done);
+
+  /**
+   * Hands the queued requests to the operating system, as many as fit in
+   * flight.
+   *
+   * @return  Number of requests handed over.
+   */
+  virtual std::size_t submit() = 0;
+
+  /**
+   * Submits every queued request and waits until all of them have completed,
+   * running their callbacks.
+   *
+   * @return  Number of requests completed.
+   */
+  std::size_t wait();
+
+  /**
+   * Runs the callbacks of the requests that have completed, without waiting.
+   *
+   * @return  Number of requests completed.
+   */
+  std::size_t poll();
+
+  /**
+   * Returns the number of requests queued or in flight.
+   */
+  std::size_t pending() const { return queued_.size() + inFlight(); }
+
+  /**
+   * Returns the kind of this engine.
+   */
+  virtual IOEngineType type() const = 0;
+
+ protected:
+  /**
+   * @brief A queued request.
+   */
+  struct Request {
+    FileIO *io;
+    char *buffer;
+    std::size_t size;
+    std::uint64_t offset;
+    bool write;
+    Callback done;
+
+    /**
+     * Buffers of a gathered write, in place of buffer; size is their total.
+     */
+    std::vector<iovec> iov;
+  };
+
+  /**
+   * Runs the request through FileIO::read(), FileIO::write() or
+   * FileIO::writev() and then its callback.
+   */
+  void runSync(Request &request);
+
+  /**
+   * Runs the callback of a completed request.
+   */
+  void finish(Request &request, const int error);
+
+  /**
+   * Returns the number of requests submitted but not completed.
+   */
+  virtual std::size_t inFlight() const = 0;
+
+  /**
+   * Completes the requests in flight that have finished, first blocking until
+   * at least one has if block is set.
+   */
+  virtual void reap(const bool block) = 0;
+
+  /**
+   * Requests queued but not submitted yet, oldest first.
+   */
+  std::deque<Request> queued_;
+
+  /**
+   * Number of requests completed so far.
+   */
+  std::size_t completed_;
+};
+
+/**
+ * @brief IOEngine that runs requests synchronously when they are submitted.
+ */
+class SyncIOEngine : public IOEngine {
+ public:
+  std::size_t submit() override;
+
+  IOEngineType type() const override { return IOEngineType::SYNC; }
+
+ protected:
+  std::size_t inFlight() const override { return 0; }
+
+  void reap(const bool block) override {}
+};
+
+/**
+ * @brief IOEngine on a Linux io_uring, driven through the raw system calls.
+ *
+ * Requests whose FileIO has no descriptor for them (see
+ * FileIO::descriptorFor()), or for one of the buffers of a gathered write, are
+ * run synchronously at submission.  A read that comes up short, at the end of
+ * the file, is finished by FileIO::read().
+ */
+class IOUringEngine : public IOEngine {
+ public:
+  /**
+   * Sets up a ring for depth requests in flight.
+   *
+   * @throws  FileIOException   If the kernel does not provide io_uring, or
+   *                            its io_uring lacks IORING_OP_READ,
+   *                            IORING_OP_WRITE or IORING_OP_WRITEV (before
+   *                            Linux 5.6).
+   */
+  explicit IOUringEngine(const unsigned depth);
+
+  ~IOUringEngine() override;
+
+  std::size_t submit() override;
+
+  IOEngineType type() const override { return IOEngineType::IO_URING; }
+
+ protected:
+  std::size_t inFlight() const override { return depth_ - free_slots_.size(); }
+
+  void reap(const bool block) override;
+
+ private:
+  /**
+   * Completes the request in slot, given the result the kernel reported.
+   */
+  void complete(const std::uint32_t slot, const int result);
+
+  /**
+   * Returns whether the ring supports the opcodes submit() issues, asking
+   * the kernel with IORING_REGISTER_PROBE.  Kernels too old to answer are
+   * also too old to have them.
+   */
+  bool supportsReadWrite() const;
+
+  /**
+   * Returns the descriptor to issue the request on, or -1 if it has to run
+   * synchronously.
+   */
+  static int descriptorFor(const Request &request);
+
+  /**
+   * Unmaps whatever parts of the ring are mapped and closes it.
+   */
+  void release();
+
+  /**
+   * Descriptor of the ring.
+   */
+  int ring_fd_;
+
+  /**
+   * Number of requests the ring takes in flight.
+   */
+  unsigned depth_;
+
+  /**
+   * Mappings of the submission queue ring, the completion queue ring and the
+   * submission queue entries, with their lengths.
+   */
+  void *sq_ring_;
+  std::size_t sq_ring_size_;
+  void *cq_ring_;
+  std::size_t cq_ring_size_;
+  void *sqes_;
+  std::size_t sqes_size_;
+
+  /**
+   * Fields of the rings shared with the kernel.
+   */
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  void *cqes_;
+
+  /**
+   * Requests in flight, by the slot number passed to the kernel as user data.
+   */
+  std::vector<Request> slots_;
+
+  /**
+   * Slots without a request in flight.
+   */
+  std::vector<std::uint32_t> free_slots_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,136 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "lru_k_policy.h"
+
+namespace badgerdb {
+
+LruKPolicy::LruKPolicy(std::uint32_t numFrames)
+    : ReplacementPolicy(numFrames),
+      now(0),
+      lists(numFrames, NUM_LISTS),
+      frames(numFrames, FrameState{0, History{0, 0}, false}) {
+  for (FrameId frame = 0; frame < numFrames; frame++)
+    lists.pushBack(FREE, frame);
+}
+
+void LruKPolicy::place(FrameId frame) {
+  const History &history = frames[frame].history;
+  if (history.penultimate == 0)
+    lists.pushBack(ONCE, frame);
+  else
+    twice.insert(std::make_pair(history.penultimate, frame));
+}
+
+void LruKPolicy::unplace(FrameId frame) {
+  const History &history = frames[frame].history;
+  if (history.penultimate == 0)
+    lists.remove(frame);
+  else
+    twice.erase(std::make_pair(history.penultimate, frame));
+}
+
+void LruKPolicy::commitEviction(FrameId frame) {
+  FrameState &state = frames[frame];
+  if (state.resident || state.pageKey == 0) return;
+  retained.pushBack(state.pageKey);
+  retainedHistory[state.pageKey] = state.history;
+  if (retained.size() > numFrames) {
+    retainedHistory.erase(retained.front());
+    retained.popFront();
+  }
+  state.pageKey = 0;
+}
+
+void LruKPolicy::onAccess(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  FrameState &state = frames[frame];
+  if (!state.resident) return;
+  unplace(frame);
+  state.history.penultimate = state.history.last;
+  state.history.last = ++now;
+  place(frame);
+}
+
+void LruKPolicy::onLoad(FrameId frame, std::uint64_t pageKey) {
+  std::lock_guard<std::mutex> guard(latch);
+  FrameState &state = frames[frame];
+  if (state.resident)
+    unplace(frame);  // reloaded in place, see frameLoaded()
+  else
+    commitEviction(frame);
+  lists.remove(frame);
+
+  state.history.penultimate = 0;
+  auto previous = retainedHistory.find(pageKey);
+  if (previous != retainedHistory.end()) {
+    state.history.penultimate = previous->second.last;
+    retainedHistory.erase(previous);
+    retained.remove(pageKey);
+  }
+  state.history.last = ++now;
+  state.pageKey = pageKey;
+  state.resident = true;
+  place(frame);
+}
+
+void LruKPolicy::frameFreed(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  FrameState &state = frames[frame];
+  if (state.resident) {
+    unplace(frame);
+    state.resident = false;
+    state.pageKey = 0;
+  } else {
+    commitEviction(frame);
+  }
+  if (lists.listOf(frame) != FREE) lists.pushBack(FREE, frame);
+}
+
+void LruKPolicy::frameRestored(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  FrameState &state = frames[frame];
+  if (state.resident || state.pageKey == 0) return;
+  state.resident = true;
+  place(frame);
+}
+
+void LruKPolicy::peekVictims(std::vector<FrameId> &frames,
+                             std::uint32_t count) {
+  std::lock_guard<std::mutex> guard(latch);
+  peekList(lists, ONCE, frames, count);
+  for (auto entry = twice.begin(); entry != twice.end() && frames.size() < count;
+       ++entry) {
+    frames.push_back(entry->second);
+  }
+}
+
+bool LruKPolicy::chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                              std::uint64_t &examined) {
+  std::lock_guard<std::mutex> guard(latch);
+  FrameId victim = claimFromList(lists, FREE, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME)
+    victim = claimFromList(lists, ONCE, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME) {
+    for (auto entry = twice.begin(); entry != twice.end(); ++entry) {
+      ++examined;
+      if (tryClaim(entry->second)) {
+        victim = entry->second;
+        twice.erase(entry);
+        break;
+      }
+    }
+  }
+  if (victim == FrameLists::NO_FRAME) return false;
+
+  frames[victim].resident = false;
+  frame = victim;
+  return true;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,128 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief LRU-K replacement with K = 2.
+ *
+ * Evicts the page whose second-to-last access is oldest.  Pages seen only once
+ * have an infinite backward 2-distance and are evicted first, oldest first.
+ * Access history of evicted pages is retained for as many pages as there are
+ * frames, so a page that comes back soon counts its earlier access.
+ */
+class LruKPolicy : public ReplacementPolicy {
+ public:
+  explicit LruKPolicy(std::uint32_t numFrames);
+
+  const char *name() const override { return "lru-2"; }
+
+  void frameFreed(FrameId frame) override;
+
+  void frameRestored(FrameId frame) override;
+
+  void peekVictims(std::vector<FrameId> &frames, std::uint32_t count) override;
+
+ protected:
+  void onAccess(FrameId frame) override;
+
+  void onLoad(FrameId frame, std::uint64_t pageKey) override;
+
+  bool chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                    std::uint64_t &examined) override;
+
+ private:
+  /**
+   * Lists of frames: empty frames, and frames whose page was accessed once.
+   */
+  enum { FREE, ONCE, NUM_LISTS };
+
+  /**
+   * @brief Access history of one page.
+   */
+  struct History {
+    /**
+     * Logical time of the last access.
+     */
+    std::uint64_t last;
+
+    /**
+     * Logical time of the access before that, or 0 if there was none.
+     */
+    std::uint64_t penultimate;
+  };
+
+  /**
+   * @brief Bookkeeping for one frame.
+   */
+  struct FrameState {
+    /**
+     * Key of the page in the frame (also while it is a victim), or 0.
+     */
+    std::uint64_t pageKey;
+
+    History history;
+
+    /**
+     * False while the frame is empty or handed out as a victim.
+     */
+    bool resident;
+  };
+
+  /**
+   * Puts a frame that holds a page back on the ONCE list or into twice.
+   */
+  void place(FrameId frame);
+
+  /**
+   * Takes a frame that holds a page off the ONCE list or out of twice.
+   */
+  void unplace(FrameId frame);
+
+  /**
+   * If frame was handed out as a victim, remembers its page's history.
+   */
+  void commitEviction(FrameId frame);
+
+  /**
+   * Latch guarding everything below.
+   */
+  std::mutex latch;
+
+  /**
+   * Logical clock for access times.
+   */
+  std::uint64_t now;
+
+  FrameLists lists;
+
+  /**
+   * Frames whose page was accessed at least twice, by penultimate access.
+   */
+  std::set<std::pair<std::uint64_t, FrameId>> twice;
+
+  std::vector<FrameState> frames;
+
+  /**
+   * Retained history of evicted pages, oldest eviction first.
+   */
+  GhostList retained;
+  std::unordered_map<std::uint64_t, History> retainedHistory;
+};
+
+}  // namespace badgerdb
@@ -1,20 +1,40 @@
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <fstream>
 #include <iostream>
 //#include <stdio.h>
 #include <cstring>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <vector>
 
+#include "bufHashTbl.h"
 #include "buffer.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/file_io_exception.h"
 #include "exceptions/file_not_found_exception.h"
+#include "exceptions/invalid_page_count_exception.h"
 #include "exceptions/invalid_page_exception.h"
+#include "exceptions/invalid_record_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
+#include "file_io.h"
 #include "file_iterator.h"
+#include "group_sync.h"
+#include "io_engine.h"
 #include "page.h"
+#include "page_directory.h"
 #include "page_iterator.h"
+#include "page_view.h"
+#include "record_view.h"
+#include "replacement_policy.h"
 
 #define PRINT_ERROR(str)                            \
   {                                                 \
@@ -40,6 +60,32 @@ void test3(File &file4);
 void test4(File &file4);
 void test5(File &file4);
 void test6(File &file1);
+void test7();
+void test8();
+void test9();
+void test10();
+void test11();
+void test12();
+void test13();
+void test14();
+void test15();
+void test16();
+void test17();
+void test18();
+void test19();
+void test20();
+void test21();
+void test22();
+void test23();
+void test24();
+void test25();
+void test26();
+void test27();
+void test28();
+void test29();
+void test30();
+void test31();
+void test32();
 // Calls the above tests
 void testBufMgr();
 
@@ -140,6 +186,32 @@ void testBufMgr() {
     test4(file4);
     test5(file5);
     test6(file1);
+    test7();
+    test8();
+    test9();
+    test10();
+    test11();
+    test12();
+    test13();
+    test14();
+    test15();
+    test16();
+    test17();
+    test18();
+    test19();
+    test20();
+    test21();
+    test22();
+    test23();
+    test24();
+    test25();
+    test26();
+    test27();
+    test28();
+    test29();
+    test30();
+    test31();
+    test32();
 
     // Close the files by going out of scope
   }
@@ -297,3 +369,1630 @@ void test6(File &file1) {
 
   bufMgr->flushFile(file1);
 }
+
+void test7() {
+  // Order in which each replacement policy gives up frames: four pages are
+  // loaded and two of them hit, then the first victim is read again at once
+  // and page 3 hit again.
+  const struct {
+    ReplacementPolicyType type;
+    FrameId first;
+    FrameId victims[4];
+  } policies[] = {
+      {ReplacementPolicyType::CLOCK, 0, {1, 3, 2, 0}},
+      {ReplacementPolicyType::LRU_K, 1, {3, 0, 1, 2}},
+      {ReplacementPolicyType::TWO_Q, 0, {1, 2, 0, 3}},
+      {ReplacementPolicyType::ARC, 1, {0, 1, 2, 3}},
+  };
+  for (const auto &expected : policies) {
+    std::unique_ptr<ReplacementPolicy> policy =
+        ReplacementPolicy::create(expected.type, 4);
+    // Claimed frames stay pinned, as in BufMgr, until their page is loaded.
+    bool claimed[4] = {false, false, false, false};
+    const ReplacementPolicy::ClaimFn tryClaim = [&claimed](FrameId frame) {
+      if (claimed[frame]) return false;
+      claimed[frame] = true;
+      return true;
+    };
+    for (FrameId frame = 0; frame < 4; frame++) {
+      policy->frameLoaded(frame, 1, frame + 1);
+    }
+    policy->frameAccessed(0);
+    policy->frameAccessed(2);
+
+    FrameId victim;
+    if (!policy->pickVictim(tryClaim, victim) || victim != expected.first) {
+      PRINT_ERROR("ERROR :: WRONG VICTIM FOR " << policy->name());
+    }
+    policy->frameLoaded(victim, 1, victim + 1);
+    claimed[victim] = false;
+    policy->frameAccessed(2);
+
+    for (int k = 0; k < 4; k++) {
+      if (!policy->pickVictim(tryClaim, victim) ||
+          victim != expected.victims[k]) {
+        PRINT_ERROR("ERROR :: WRONG VICTIM FOR " << policy->name());
+      }
+    }
+    if (policy->pickVictim(tryClaim, victim)) {
+      PRINT_ERROR("ERROR :: CLAIMED FRAME GIVEN UP TWICE BY "
+                  << policy->name());
+    }
+  }
+
+  std::cout << "Test 7 passed"
+            << "\n";
+}
+
+// Creates a file of num_pages pages, page p holding the record
+// "<filename> Page <p>".
+void createNumberedFile(File &file, const PageId num_pages) {
+  for (PageId k = 0; k < num_pages; k++) {
+    Page new_page = file.allocatePage();
+    sprintf(tmpbuf, "%s Page %u", file.filename().c_str(),
+            new_page.page_number());
+    new_page.insertRecord(tmpbuf);
+    file.writePage(new_page);
+  }
+}
+
+void test8() {
+  // Hits and misses of a scan through a ring of four frames: the scan
+  // recycles its frames, and the pages read before it stay in the pool.
+  const std::string filename = "test.ring";
+  const PageId num_pages = 48;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, num_pages);
+
+    BufMgr scanBufMgr(16);
+    Page *scan_page;
+    for (PageId pageNo = 41; pageNo <= num_pages; pageNo++) {
+      scanBufMgr.readPage(file, pageNo, scan_page);
+      scanBufMgr.unPinPage(file, pageNo, false);
+    }
+    BufAccessStrategy strategy(4);
+    for (PageId pageNo = 1; pageNo <= 32; pageNo++) {
+      scanBufMgr.readPage(file, pageNo, scan_page, &strategy);
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (scan_page->getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      scanBufMgr.unPinPage(file, pageNo, false);
+    }
+    for (PageId pageNo = 41; pageNo <= num_pages; pageNo++) {
+      scanBufMgr.readPage(file, pageNo, scan_page);
+      scanBufMgr.unPinPage(file, pageNo, false);
+    }
+
+    const BufStats stats = scanBufMgr.getBufStats();
+    const ReplacementStats policyStats = scanBufMgr.getReplacementStats();
+    if (strategy.getRingReuses() != 32 - 4) {
+      PRINT_ERROR("ERROR :: RING FRAMES NOT RECYCLED");
+    }
+    if (stats.accesses != 48 || stats.diskreads != 40 ||
+        policyStats.hits != 8 || policyStats.misses != 40) {
+      PRINT_ERROR("ERROR :: SCAN PUSHED OUT OTHER PAGES");
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 8 passed"
+            << "\n";
+}
+
+void test9() {
+  // A sequential scan with read-ahead reads every page once, most of them
+  // ahead of the scan, which then hits them.
+  const std::string filename = "test.readahead";
+  const PageId num_pages = 48;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, num_pages);
+
+    BufMgr scanBufMgr(64);
+    scanBufMgr.setMaxReadAhead(8);
+    Page *scan_page;
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      scanBufMgr.readPage(file, pageNo, scan_page);
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (scan_page->getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      scanBufMgr.unPinPage(file, pageNo, false);
+    }
+
+    const BufStats stats = scanBufMgr.getBufStats();
+    const ReplacementStats policyStats = scanBufMgr.getReplacementStats();
+    if (stats.accesses != static_cast<int>(num_pages) ||
+        stats.diskreads != static_cast<int>(num_pages) ||
+        stats.prefetched < static_cast<int>(num_pages) / 2 ||
+        policyStats.hits != static_cast<std::uint64_t>(stats.prefetched) ||
+        policyStats.misses != num_pages) {
+      PRINT_ERROR("ERROR :: READ-AHEAD MISCOUNTED");
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 9 passed"
+            << "\n";
+}
+
+void test10() {
+  // Pinning, unpinning and evicting pages from several threads at once, with
+  // four times as many pages as frames.
+  const std::string filename = "test.threads";
+  const PageId num_pages = 64;
+  const int num_threads = 4;
+  const int reads = 2000;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, num_pages);
+    BufMgr threadBufMgr(num_pages / 4);
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t]() {
+        char expected[100];
+        unsigned int seed = t;
+        for (int k = 0; k < reads; k++) {
+          const PageId pageNo = 1 + rand_r(&seed) % num_pages;
+          PinnedPage pinned = threadBufMgr.readPage(file, pageNo);
+          sprintf(expected, "%s Page %u", filename.c_str(), pageNo);
+          if (pinned->getRecord({pageNo, 1}) != expected) mismatches++;
+          if (k % 8 == 0) pinned.markDirty();
+        }
+      });
+    }
+    for (std::thread &thread : threads) thread.join();
+    if (mismatches != 0) {
+      PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+    }
+
+    // Every access either hit or loaded the page, exactly once; pages read
+    // ahead were loaded without an access.
+    const BufStats stats = threadBufMgr.getBufStats();
+    const ReplacementStats policyStats = threadBufMgr.getReplacementStats();
+    if (stats.accesses != num_threads * reads ||
+        policyStats.hits + policyStats.misses !=
+            static_cast<std::uint64_t>(stats.accesses + stats.prefetched) ||
+        policyStats.misses != static_cast<std::uint64_t>(stats.diskreads) ||
+        policyStats.evictions + num_pages / 4 < policyStats.misses) {
+      PRINT_ERROR("ERROR :: ACCESSES MISCOUNTED");
+    }
+
+    // No page is left pinned.
+    threadBufMgr.flushFile(file);
+  }
+  File::remove(filename);
+
+  std::cout << "Test 10 passed"
+            << "\n";
+}
+
+void test11() {
+  // Deleted records leave their space fragmented, and nothing on the page
+  // moves until an insert needs that space.
+  Page page;
+  RecordId rids[8];
+  for (int k = 0; k < 8; k++) {
+    rids[k] = page.insertRecord(std::string(1000, 'a' + k));
+  }
+  const std::uint16_t free_space = page.getFreeSpace();
+  const char *last = page.viewRecord(rids[7]).data();
+  page.deleteRecord(rids[2]);
+  page.deleteRecord(rids[6]);
+  page.deleteRecord(rids[4]);
+  if (page.getFreeSpace() != free_space + 3000 ||
+      page.viewRecord(rids[7]).data() != last) {
+    PRINT_ERROR("ERROR :: DELETE COMPACTED THE PAGE");
+  }
+
+  // Fits in the contiguous free space, so nothing moves.
+  const RecordId small = page.insertRecord(std::string(100, 'x'));
+  if (page.viewRecord(rids[7]).data() != last) {
+    PRINT_ERROR("ERROR :: INSERT COMPACTED THE PAGE");
+  }
+  // Needs the fragmented space, so the page is compacted.
+  const RecordId large = page.insertRecord(std::string(2000, 'y'));
+  if (page.getRecord(small) != std::string(100, 'x') ||
+      page.getRecord(large) != std::string(2000, 'y')) {
+    PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH AFTER COMPACTION");
+  }
+  const int kept[] = {0, 1, 3, 5, 7};
+  for (const int k : kept) {
+    if (page.getRecord(rids[k]) != std::string(1000, 'a' + k)) {
+      PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH AFTER COMPACTION");
+    }
+  }
+
+  std::cout << "Test 11 passed"
+            << "\n";
+}
+
+void test12() {
+  // Freed slots are chained for reuse, most recently freed first; with the
+  // chain empty, the next record takes a new slot.
+  Page page;
+  RecordId rids[8];
+  for (int k = 0; k < 8; k++) {
+    rids[k] = page.insertRecord(std::string(1000, 'a' + k));
+  }
+  page.deleteRecord(rids[2]);
+  page.deleteRecord(rids[6]);
+  page.deleteRecord(rids[4]);
+
+  const SlotId expected[] = {5, 7, 3};
+  const std::size_t lengths[] = {100, 2000, 1000};
+  for (int k = 0; k < 3; k++) {
+    const RecordId rid = page.insertRecord(std::string(lengths[k], 'x' + k));
+    if (rid.slot_number != expected[k] ||
+        page.getRecord(rid) != std::string(lengths[k], 'x' + k)) {
+      PRINT_ERROR("ERROR :: FREE SLOT CHAIN OUT OF ORDER");
+    }
+  }
+
+  const RecordId rid = page.insertRecord(
+      std::string(page.getFreeSpace() - sizeof(PageSlot), 'w'));
+  if (rid.slot_number != 9 || page.getFreeSpace() != 0) {
+    PRINT_ERROR("ERROR :: NEW SLOT NOT ADDED");
+  }
+  RecordId overflow;
+  if (page.tryInsertRecord("v", overflow) == Status::OK) {
+    PRINT_ERROR("ERROR :: INSERTED INTO A FULL PAGE");
+  }
+
+  std::cout << "Test 12 passed"
+            << "\n";
+}
+
+// Writes a version 1 file, with six-byte slots, holding the given records on
+// consecutive pages after its header page.
+void writeVersion1Pages(const std::string &filename,
+                        const std::vector<std::vector<std::string>> &pages) {
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  const PageId num_pages = pages.size() + 1;
+  const PageId v1_header[4] = {num_pages, 1 /* first_used_page */,
+                               0 /* num_free_pages */, 0 /* first_free_page */};
+  out.write(reinterpret_cast<const char *>(v1_header), sizeof(v1_header));
+  const std::string padding(Page::SIZE - sizeof(v1_header), '\0');
+  out.write(padding.data(), padding.size());
+  for (PageId p = 1; p < num_pages; ++p) {
+    const std::vector<std::string> &records = pages[p - 1];
+    std::vector<char> bytes(Page::SIZE);
+    char *data = bytes.data() + 16;
+    std::uint16_t upper = Page::SIZE - 16;
+    for (std::size_t k = 0; k < records.size(); ++k) {
+      const std::uint16_t length = records[k].size();
+      upper -= length;
+      memcpy(data + upper, records[k].data(), length);
+      data[k * 6] = 1;
+      memcpy(data + k * 6 + 2, &upper, 2);
+      memcpy(data + k * 6 + 4, &length, 2);
+    }
+    const std::uint16_t v1_page_header[4] = {
+        static_cast<std::uint16_t>(6 * records.size()), upper,
+        static_cast<std::uint16_t>(records.size()), 0};
+    const PageId numbers[2] = {p, p + 1 < num_pages ? p + 1 : 0};
+    memcpy(bytes.data(), v1_page_header, sizeof(v1_page_header));
+    memcpy(bytes.data() + 8, numbers, sizeof(numbers));
+    out.write(bytes.data(), bytes.size());
+  }
+}
+
+// Checks that a page holds exactly the given records, each in the slot it
+// was given, after a write to and a read from its file.
+void checkRecords(
+    File &file, const Page &page,
+    const std::vector<std::pair<RecordId, std::string>> &records) {
+  file.writePage(page);
+  Page read_page = file.readPage(page.page_number());
+  std::size_t k = 0;
+  for (PageIterator iter = read_page.begin(); iter != read_page.end();
+       ++iter, ++k) {
+    if (k == records.size() || iter.record_id() != records[k].first ||
+        *iter != records[k].second) {
+      PRINT_ERROR("ERROR :: RECORDS DID NOT MATCH");
+    }
+  }
+  if (k != records.size()) {
+    PRINT_ERROR("ERROR :: RECORDS LOST");
+  }
+}
+
+void test13() {
+  // A full page of records of many lengths, some of them deleted and all its
+  // free space then taken by one record that needs the page compacted first,
+  // keeps every record in its slot.
+  const std::string filename = "test.slots";
+  {
+    File file = File::create(filename);
+    Page page = file.allocatePage();
+    std::vector<std::pair<RecordId, std::string>> records;
+    for (std::size_t k = 0;; ++k) {
+      std::string record((k * 37) % 200 + 1, static_cast<char>('a' + k % 26));
+      RecordId rid;
+      if (page.tryInsertRecord(record, rid) != Status::OK) break;
+      records.push_back({rid, record});
+    }
+    std::size_t last_freed = records.size() - 2;
+    for (std::size_t k = last_freed; k < records.size(); k -= 3) {
+      page.deleteRecord(records[k].first);
+      records.erase(records.begin() + k);
+      last_freed = k;
+    }
+    const std::string filler(page.getFreeSpace(), 'f');
+    const RecordId filler_rid = page.insertRecord(filler);
+    records.insert(records.begin() + last_freed, {filler_rid, filler});
+    // Slots were numbered from 1 and deleted from the last one down, so the
+    // slot freed last is reused.
+    if (filler_rid.slot_number != last_freed + 1 || page.getFreeSpace() != 0) {
+      PRINT_ERROR("ERROR :: FREED SPACE NOT REUSED");
+    }
+    checkRecords(file, page, records);
+  }
+  File::remove(filename);
+
+  // Version 1 pages holding the longest record and as many of the shortest
+  // records as fit keep them when their slots are packed.
+  {
+    const std::string longest_v1(Page::DATA_SIZE - 6, 'l');
+    const std::vector<std::string> shortest_v1(Page::DATA_SIZE / 7, "s");
+    writeVersion1Pages(filename, {{longest_v1}, shortest_v1});
+    File file = File::open(filename);
+    Page longest_page = file.readPage(1);
+    checkRecords(file, longest_page, {{{1, 1}, longest_v1}});
+    Page shortest_page = file.readPage(2);
+    std::vector<std::pair<RecordId, std::string>> records;
+    for (SlotId slot = 1; slot <= shortest_v1.size(); ++slot) {
+      records.push_back({{2, slot}, "s"});
+    }
+    if (shortest_page.getFreeSpace() != 2 * shortest_v1.size()) {
+      PRINT_ERROR("ERROR :: PACKED SLOTS DID NOT FREE THEIR SPACE");
+    }
+    checkRecords(file, shortest_page, records);
+  }
+  File::remove(filename);
+
+  // The longest record a page holds, right after its slot, and the shortest
+  // at the very end of the page, survive a write and a read.
+  {
+    File file = File::create(filename);
+    Page page = file.allocatePage();
+    const std::string longest(Page::DATA_SIZE - sizeof(PageSlot), 'l');
+    RecordId rid = page.insertRecord(longest);
+    const char *start = reinterpret_cast<const char *>(&page);
+    if (page.viewRecord(rid).data() !=
+        start + sizeof(PageHeader) + sizeof(PageSlot)) {
+      PRINT_ERROR("ERROR :: LONGEST RECORD MISPLACED");
+    }
+    file.writePage(page);
+    if (file.readPage(page.page_number()).getRecord(rid) != longest) {
+      PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+    }
+
+    page.deleteRecord(rid);
+    rid = page.insertRecord("s");
+    if (page.viewRecord(rid).data() != start + Page::SIZE - 1) {
+      PRINT_ERROR("ERROR :: SHORTEST RECORD MISPLACED");
+    }
+    file.writePage(page);
+    if (file.readPage(page.page_number()).getRecord(rid) != "s") {
+      PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 13 passed"
+            << "\n";
+}
+
+void test14() {
+  // A page directory spanning several directory pages survives being stored
+  // and loaded again.
+  PageDirectory directory;
+  const int num_directory_pages = 3;
+  for (int k = 0; k < num_directory_pages; k++) {
+    directory.addDirectoryPage(PageId(directory.capacity()));
+  }
+  const PageId num_pages = PageId(directory.capacity());
+  for (PageId pageNo = 1; pageNo < num_pages; pageNo += 7) {
+    if (!directory.isUsed(pageNo)) directory.setUsed(pageNo, true);
+  }
+  directory.setUsed(num_pages - 1, true);
+
+  std::vector<char> header_area(Page::SIZE - PageDirectory::HEADER_AREA_OFFSET);
+  directory.storeHeaderArea(header_area.data());
+  std::vector<std::vector<char>> pages(num_directory_pages,
+                                      std::vector<char>(Page::SIZE));
+  for (int k = 0; k < num_directory_pages; k++) {
+    directory.storeDirectoryPage(k, pages[k].data());
+  }
+
+  PageDirectory loaded;
+  loaded.loadHeaderArea(header_area.data());
+  for (int k = 0; k < num_directory_pages; k++) {
+    loaded.loadDirectoryPage(k, pages[k].data());
+  }
+  if (loaded.directoryPages() != directory.directoryPages() ||
+      loaded.capacity() != directory.capacity()) {
+    PRINT_ERROR("ERROR :: DIRECTORY PAGES LOST");
+  }
+  for (PageId pageNo = 0; pageNo < num_pages; pageNo++) {
+    if (loaded.isUsed(pageNo) != directory.isUsed(pageNo)) {
+      PRINT_ERROR("ERROR :: DIRECTORY BITS DID NOT MATCH");
+    }
+  }
+  if (loaded.findFree(num_pages) != 2 ||
+      loaded.nextUsed(Page::INVALID_NUMBER, num_pages) != 1) {
+    PRINT_ERROR("ERROR :: LOADED DIRECTORY SEARCHES WRONG");
+  }
+
+  std::cout << "Test 14 passed"
+            << "\n";
+}
+
+// Writes a version 1 file of num_pages pages, in the unaligned layout (pages
+// right after the 16-byte header) or the aligned one.  Page p holds records
+// "p<p> r<r>" in slots 1 and 3, slot 2 having been deleted, except for the
+// last page, which is free.
+void writeVersion1File(const std::string &filename, const PageId num_pages,
+                       const bool aligned) {
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  const PageId v1_header[4] = {num_pages, 1 /* first_used_page */,
+                               1 /* num_free_pages */,
+                               num_pages - 1 /* first_free_page */};
+  out.write(reinterpret_cast<const char *>(v1_header), sizeof(v1_header));
+  if (aligned) {
+    const std::string padding(Page::SIZE - sizeof(v1_header), '\0');
+    out.write(padding.data(), padding.size());
+  }
+  for (PageId p = 1; p < num_pages; ++p) {
+    char bytes[Page::SIZE] = {};
+    char *data = bytes + 16;
+    std::uint16_t upper = Page::SIZE - 16;
+    for (std::uint16_t slot = 1; slot <= 3; ++slot) {
+      if (slot == 2 || p == num_pages - 1) continue;
+      sprintf(tmpbuf, "p%u r%u", p, slot);
+      const std::uint16_t length = strlen(tmpbuf);
+      upper -= length;
+      memcpy(data + upper, tmpbuf, length);
+      // Six-byte slot: used flag, padding, offset, length.
+      data[(slot - 1) * 6] = 1;
+      memcpy(data + (slot - 1) * 6 + 2, &upper, 2);
+      memcpy(data + (slot - 1) * 6 + 4, &length, 2);
+    }
+    const bool used = p != num_pages - 1;
+    // Header: free space lower and upper bounds, slot count, free slot count,
+    // page number and next page number.
+    const std::uint16_t v1_page_header[4] = {
+        static_cast<std::uint16_t>(used ? 18 : 0), upper,
+        static_cast<std::uint16_t>(used ? 3 : 0),
+        static_cast<std::uint16_t>(used ? 1 : 0)};
+    const PageId numbers[2] = {used ? p : Page::INVALID_NUMBER,
+                               used && p + 2 < num_pages ? p + 1 : 0};
+    memcpy(bytes, v1_page_header, sizeof(v1_page_header));
+    memcpy(bytes + 8, numbers, sizeof(numbers));
+    out.write(bytes, sizeof(bytes));
+  }
+}
+
+// Checks the records writeVersion1File() put in a file, now converted.
+void checkVersion1File(const std::string &filename, const PageId num_pages) {
+  File file = File::open(filename);
+  PageId records = 0;
+  for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+    Page curr_page = *iter;
+    for (PageIterator page_iter = curr_page.begin();
+         page_iter != curr_page.end(); ++page_iter) {
+      const RecordId record_id = page_iter.record_id();
+      sprintf(tmpbuf, "p%u r%u", record_id.page_number,
+              record_id.slot_number);
+      if (*page_iter != tmpbuf) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      ++records;
+    }
+  }
+  if (records != 2 * (num_pages - 2)) {
+    PRINT_ERROR("ERROR :: RECORDS LOST IN CONVERSION");
+  }
+  // The deleted slot is reused first.
+  Page converted = file.readPage(1);
+  if (converted.insertRecord("new").slot_number != 2) {
+    PRINT_ERROR("ERROR :: FREE SLOT NOT REUSED");
+  }
+}
+
+void test15() {
+  // Converting version 1 files, in both layouts, including after a
+  // conversion of an unaligned file that crashed partway.
+  const std::string filename = "test.v1";
+  const std::string converted = filename + ".convert";
+  const PageId v1_pages = 20;
+
+  writeVersion1File(filename, v1_pages, true /* aligned */);
+  checkVersion1File(filename, v1_pages);
+  File::remove(filename);
+
+  writeVersion1File(filename, v1_pages, false /* aligned */);
+  std::ifstream in(filename, std::ios::binary);
+  const std::string original((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+  in.close();
+
+  // A conversion that fails before its copy is renamed into place leaves the
+  // original untouched.  A directory in the way, which is not empty so that
+  // it is not removed as a stale copy, makes it fail.
+  const std::string blocker = converted + "/blocker";
+  mkdir(converted.c_str(), 0700);
+  std::ofstream(blocker).close();
+  try {
+    File::open(filename);
+    PRINT_ERROR(
+        "ERROR :: Conversion copy cannot be created. Exception should have "
+        "been thrown before execution reaches this point.");
+  } catch (const FileIOException &e) {
+  }
+  unlink(blocker.c_str());
+  rmdir(converted.c_str());
+  in.open(filename, std::ios::binary);
+  if (std::string((std::istreambuf_iterator<char>(in)),
+                  std::istreambuf_iterator<char>()) != original) {
+    PRINT_ERROR("ERROR :: FAILED CONVERSION CHANGED THE FILE");
+  }
+  in.close();
+
+  // A copy left by a crash, cut off after a few pages, is discarded.
+  std::ofstream partial(converted, std::ios::binary);
+  partial.write(original.data(), 3 * Page::SIZE);
+  partial.close();
+  checkVersion1File(filename, v1_pages);
+  if (access(converted.c_str(), F_OK) == 0) {
+    PRINT_ERROR("ERROR :: CONVERSION COPY LEFT BEHIND");
+  }
+  struct stat file_stat;
+  stat(filename.c_str(), &file_stat);
+  if (file_stat.st_size % Page::SIZE != 0) {
+    PRINT_ERROR("ERROR :: CONVERTED FILE NOT ALIGNED");
+  }
+  checkVersion1File(filename, v1_pages);
+  File::remove(filename);
+
+  std::cout << "Test 15 passed"
+            << "\n";
+}
+
+void test16() {
+  // Allocating runs of pages, in holes left by deleted pages and at the end
+  // of the file across a directory page.
+  const std::string filename = "test.runs";
+  {
+    File file = File::create(filename);
+    for (i = 0; i < 10; i++) {
+      file.allocatePage();
+    }
+    file.deletePage(3);
+    file.deletePage(4);
+    file.deletePage(5);
+    file.deletePage(8);
+    PageRun run = file.allocatePages(3);
+    if (run.first != 3 || run.count != 3) {
+      PRINT_ERROR("ERROR :: RUN NOT TAKEN FROM FREED PAGES");
+    }
+    run = file.allocatePages(2);
+    if (run.first <= 10) {
+      PRINT_ERROR("ERROR :: RUN OVERLAPS USED PAGES");
+    }
+    if (file.allocatePage().page_number() != 8) {
+      PRINT_ERROR("ERROR :: FREED PAGE NOT REUSED");
+    }
+
+    // The longest run there can be, which only fits past the first
+    // directory page.
+    const PageId longest = PageDirectory::DIRECTORY_PAGE_BITS - 1;
+    run = file.allocatePages(longest);
+    const PageId last = run.first + run.count - 1;
+    if (run.first <= PageDirectory::HEADER_BITS ||
+        file.readPage(run.first).page_number() != run.first ||
+        file.readPage(last).page_number() != last) {
+      PRINT_ERROR("ERROR :: RUN NOT ALLOCATED PAST THE DIRECTORY PAGE");
+    }
+
+    // Empty runs, and runs that cannot fit between two directory pages.
+    const PageId invalid_counts[] = {0, longest + 1};
+    for (const PageId count : invalid_counts) {
+      try {
+        file.allocatePages(count);
+        PRINT_ERROR("ERROR :: INVALID RUN LENGTH ACCEPTED");
+      } catch (const InvalidPageCountException &e) {
+      }
+    }
+  }
+  {
+    File file = File::open(filename);
+    PageId pages = 0;
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      ++pages;
+    }
+    if (pages != 12 + PageDirectory::DIRECTORY_PAGE_BITS - 1) {
+      PRINT_ERROR("ERROR :: ALLOCATED PAGES LOST");
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 16 passed"
+            << "\n";
+}
+
+void test17() {
+  // Destroying a buffer manager with a dirty page that was deleted from its
+  // file directly drops that page and still writes back the others.
+  const std::string filename = "test.dtor";
+  {
+    File file = File::create(filename);
+    PageId deleted_page, kept_page;
+    {
+      BufMgr dtorBufMgr(4);
+      Page *dtor_page;
+      dtorBufMgr.allocPage(file, deleted_page, dtor_page);
+      dtor_page->insertRecord("deleted");
+      dtorBufMgr.unPinPage(file, deleted_page, true);
+      dtorBufMgr.allocPage(file, kept_page, dtor_page);
+      dtor_page->insertRecord("kept");
+      dtorBufMgr.unPinPage(file, kept_page, true);
+      file.deletePage(deleted_page);
+    }
+    if (file.readPage(kept_page).getRecord({kept_page, 1}) != "kept") {
+      PRINT_ERROR("ERROR :: DIRTY PAGE NOT WRITTEN BACK");
+    }
+    try {
+      file.readPage(deleted_page);
+      PRINT_ERROR("ERROR :: DELETED PAGE WRITTEN BACK");
+    } catch (const InvalidPageException &e) {
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 17 passed"
+            << "\n";
+}
+
+void test18() {
+  // A file that a crash left with part of a page past its last one is still
+  // opened as the current format, without that part; one shorter than its
+  // header says is rejected.
+  const std::string filename = "test.torn";
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, 5);
+  }
+  struct stat file_stat;
+  stat(filename.c_str(), &file_stat);
+  const off_t full_size = file_stat.st_size;
+  {
+    std::ofstream out(filename, std::ios::binary | std::ios::app);
+    const std::string torn(100, 'x');
+    out.write(torn.data(), torn.size());
+  }
+  {
+    File file = File::open(filename);
+    PageId pages = 0;
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(),
+              (*iter).page_number());
+      if ((*iter).getRecord({(*iter).page_number(), 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+      ++pages;
+    }
+    if (pages != 5) {
+      PRINT_ERROR("ERROR :: PAGES LOST");
+    }
+  }
+  stat(filename.c_str(), &file_stat);
+  if (file_stat.st_size != full_size) {
+    PRINT_ERROR("ERROR :: PARTIAL PAGE NOT TRUNCATED");
+  }
+
+  if (truncate(filename.c_str(), full_size - Page::SIZE) != 0) {
+    PRINT_ERROR("ERROR :: COULD NOT TRUNCATE");
+  }
+  try {
+    File::open(filename);
+    PRINT_ERROR("ERROR :: OPENED A FILE MISSING PAGES");
+  } catch (const FileIOException &e) {
+  }
+  File::remove(filename);
+
+  std::cout << "Test 18 passed"
+            << "\n";
+}
+
+void test19() {
+  // Writes batched on an IOEngine to a memory-mapped file, growing it, are
+  // read back through the mapping.
+  const std::string filename = "test.mmap";
+  const PageId num_pages = 8;
+  {
+    std::unique_ptr<FileIO> io =
+        FileIO::open(FileBackend::MMAP, filename, true /* create_new */);
+    std::unique_ptr<IOEngine> engine = IOEngine::create();
+    std::vector<Page> pages(num_pages);
+    int errors = 0;
+    for (PageId k = 0; k < num_pages; k++) {
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), k);
+      pages[k].insertRecord(tmpbuf);
+      engine->queueWrite(*io, reinterpret_cast<const char *>(&pages[k]),
+                         Page::SIZE, k * Page::SIZE,
+                         [&errors](int error) { errors += error != 0; });
+    }
+    engine->wait();
+    if (errors != 0 || io->size() != num_pages * Page::SIZE) {
+      PRINT_ERROR("ERROR :: ENGINE WRITES LOST");
+    }
+    for (PageId k = 0; k < num_pages; k++) {
+      Page page;
+      io->read(reinterpret_cast<char *>(&page), Page::SIZE, k * Page::SIZE);
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), k);
+      if (page.getRecord({0, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+      }
+    }
+  }
+  File::remove(filename);
+
+  // The buffer manager flushes dirty pages of a memory-mapped file on its
+  // engine too.
+  {
+    File file = File::create(filename, FileBackend::MMAP);
+    createNumberedFile(file, num_pages);
+    BufMgr mmapBufMgr(num_pages);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      PinnedPage pinned = mmapBufMgr.readPage(file, pageNo);
+      pinned->insertRecord("flushed");
+      pinned.markDirty();
+    }
+    mmapBufMgr.flushFile(file);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      if (file.readPage(pageNo).getRecord({pageNo, 2}) != "flushed") {
+        PRINT_ERROR("ERROR :: FLUSHED PAGE NOT READ BACK");
+      }
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 19 passed"
+            << "\n";
+}
+
+void test20() {
+  // Gathered writes on each kind of engine.
+  const std::string filename = "test.engine";
+  const IOEngineType types[] = {IOEngineType::IO_URING, IOEngineType::SYNC};
+  for (const IOEngineType type : types) {
+    std::unique_ptr<FileIO> io =
+        FileIO::open(FileBackend::POSIX, filename, true /* create_new */);
+    std::unique_ptr<IOEngine> engine = IOEngine::create(type);
+    std::vector<Page> pages(3);
+    iovec iov[3];
+    for (int k = 0; k < 3; k++) {
+      sprintf(tmpbuf, "%s Page %d", filename.c_str(), k);
+      pages[k].insertRecord(tmpbuf);
+      iov[k].iov_base = &pages[2 - k];
+      iov[k].iov_len = Page::SIZE;
+    }
+    int error = 0;
+    engine->queueWritev(*io, iov, 3, Page::SIZE,
+                        [&error](int result) { error = result; });
+    engine->wait();
+    for (int k = 0; k < 3; k++) {
+      Page page;
+      io->read(reinterpret_cast<char *>(&page), Page::SIZE,
+               (k + 1) * Page::SIZE);
+      sprintf(tmpbuf, "%s Page %d", filename.c_str(), 2 - k);
+      if (error != 0 || page.getRecord({0, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: GATHERED WRITE DID NOT MATCH");
+      }
+    }
+  }
+  File::remove(filename);
+
+  // Flushing writes each run of dirty frames in place, in requests of at most
+  // IOV_MAX frames.
+  const PageId num_pages = IOV_MAX + 100;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, num_pages);
+    BufMgr engineBufMgr(num_pages);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      PinnedPage pinned = engineBufMgr.readPage(file, pageNo);
+      // Every 50th page is left clean, splitting the rest into runs.
+      if (pageNo % 50 != 0) {
+        pinned->insertRecord("flushed");
+        pinned.markDirty();
+      }
+    }
+    engineBufMgr.flushFile(file);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      Page page = file.readPage(pageNo);
+      int records = 0;
+      for (PageIterator iter = page.begin(); iter != page.end(); ++iter) {
+        ++records;
+      }
+      const bool flushed = pageNo % 50 != 0;
+      if (records != (flushed ? 2 : 1) ||
+          (flushed && page.getRecord({pageNo, 2}) != "flushed")) {
+        PRINT_ERROR("ERROR :: FLUSHED PAGE DID NOT MATCH");
+      }
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 20 passed"
+            << "\n";
+}
+
+void test21() {
+  // Entries of two files, many more than the table was sized for, so that
+  // its partitions grow, survive removing every other one and inserting them
+  // again, when the probe sequences of the others shift back over them.
+  const std::string filename1 = "test.hash1";
+  const std::string filename2 = "test.hash2";
+  const PageId num_pages = 500;
+  {
+    File file1 = File::create(filename1);
+    File file2 = File::create(filename2);
+    BufHashTbl hashTable(16);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      hashTable.insert(file1, pageNo, pageNo);
+      hashTable.insert(file2, pageNo, num_pages + pageNo);
+    }
+    FrameId frameNo;
+    if (hashTable.tryInsert(file1, 1, 0) != Status::HASH_ALREADY_PRESENT) {
+      PRINT_ERROR("ERROR :: DUPLICATE ENTRY INSERTED");
+    }
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo += 2) {
+      hashTable.remove(file1, pageNo);
+    }
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      const Status status = hashTable.tryLookup(file1, pageNo, frameNo);
+      if (pageNo % 2 == 1 ? status != Status::HASH_NOT_FOUND
+                          : status != Status::OK || frameNo != pageNo) {
+        PRINT_ERROR("ERROR :: ENTRY LOST AFTER REMOVAL");
+      }
+      hashTable.lookup(file2, pageNo, frameNo);
+      if (frameNo != num_pages + pageNo) {
+        PRINT_ERROR("ERROR :: ENTRY OF OTHER FILE CHANGED");
+      }
+    }
+    if (hashTable.tryRemove(file1, 1) != Status::HASH_NOT_FOUND) {
+      PRINT_ERROR("ERROR :: REMOVED ENTRY REMOVED AGAIN");
+    }
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo += 2) {
+      hashTable.insert(file1, pageNo, 2 * num_pages + pageNo);
+    }
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      hashTable.lookup(file1, pageNo, frameNo);
+      if (frameNo != (pageNo % 2 == 1 ? 2 * num_pages : 0) + pageNo) {
+        PRINT_ERROR("ERROR :: REINSERTED ENTRY DID NOT MATCH");
+      }
+      hashTable.remove(file1, pageNo);
+      hashTable.remove(file2, pageNo);
+    }
+    if (hashTable.tryLookup(file2, num_pages, frameNo) !=
+        Status::HASH_NOT_FOUND) {
+      PRINT_ERROR("ERROR :: ENTRY LEFT AFTER REMOVING ALL");
+    }
+  }
+  File::remove(filename1);
+  File::remove(filename2);
+
+  std::cout << "Test 21 passed"
+            << "\n";
+}
+
+void test22() {
+  // The non-throwing variants report misses and errors as a Status and leave
+  // the state they would have changed alone.
+  const std::string filename = "test.status";
+  const PageId num_pages = 3;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, num_pages);
+
+    Page file_page;
+    if (file.tryReadPage(num_pages + 1, file_page) != Status::INVALID_PAGE) {
+      PRINT_ERROR("ERROR :: MISSING PAGE READ FROM FILE");
+    }
+    sprintf(tmpbuf, "%s Page %u", filename.c_str(), 2);
+    if (file.tryReadPage(2, file_page) != Status::OK ||
+        file_page.getRecord({2, 1}) != tmpbuf) {
+      PRINT_ERROR("ERROR :: PAGE NOT READ FROM FILE");
+    }
+
+    BufMgr statusBufMgr(2);
+    Page *status_page;
+    if (statusBufMgr.tryReadPage(file, num_pages + 1, status_page) !=
+        Status::INVALID_PAGE) {
+      PRINT_ERROR("ERROR :: MISSING PAGE READ INTO POOL");
+    }
+    for (PageId pageNo = 1; pageNo <= 2; pageNo++) {
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (statusBufMgr.tryReadPage(file, pageNo, status_page) != Status::OK ||
+          status_page->getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: PAGE NOT READ INTO POOL");
+      }
+    }
+    if (statusBufMgr.tryReadPage(file, 3, status_page) !=
+        Status::BUFFER_EXCEEDED) {
+      PRINT_ERROR("ERROR :: PAGE READ INTO A FULL POOL");
+    }
+    statusBufMgr.unPinPage(file, 1, false);
+    if (statusBufMgr.tryReadPage(file, 3, status_page) != Status::OK) {
+      PRINT_ERROR("ERROR :: PAGE NOT READ INTO A FREED FRAME");
+    }
+    statusBufMgr.unPinPage(file, 2, false);
+    statusBufMgr.unPinPage(file, 3, false);
+  }
+  File::remove(filename);
+
+  Page page;
+  const std::string small_record = "small";
+  const std::string large_record(Page::DATA_SIZE, 'x');
+  RecordId rid;
+  if (page.tryInsertRecord(large_record, rid) != Status::INSUFFICIENT_SPACE ||
+      page.begin() != page.end()) {
+    PRINT_ERROR("ERROR :: RECORD TOO LARGE INSERTED");
+  }
+  if (page.tryInsertRecord(small_record, rid) != Status::OK ||
+      page.getRecord(rid) != small_record) {
+    PRINT_ERROR("ERROR :: RECORD NOT INSERTED");
+  }
+  if (page.tryUpdateRecord(rid, large_record) != Status::INSUFFICIENT_SPACE ||
+      page.getRecord(rid) != small_record) {
+    PRINT_ERROR("ERROR :: RECORD UPDATED PAST THE PAGE");
+  }
+  if (page.tryUpdateRecord(rid, "updated") != Status::OK ||
+      page.getRecord(rid) != "updated") {
+    PRINT_ERROR("ERROR :: RECORD NOT UPDATED");
+  }
+
+  std::cout << "Test 22 passed"
+            << "\n";
+}
+
+// Waits up to a few seconds for the background writer of bufMgr to have
+// written at least pages pages back.
+bool waitForBackgroundWrites(const BufMgr &bufMgr, const int pages) {
+  for (int round = 0; round < 500; round++) {
+    if (bufMgr.getBufStats().bgwrites >= pages) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
+void test23() {
+  // The background writer writes back the dirty pages the clock hand is
+  // about to reach, so that evicting them needs no write.
+  const std::string filename = "test.bgwriter";
+  const PageId num_bufs = 8;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, 2 * num_bufs);
+    BufMgr bgBufMgr(num_bufs);
+    // The last page read sweeps the clock once, evicting and writing one page
+    // and clearing the reference bits of the others.
+    for (PageId pageNo = 1; pageNo <= num_bufs + 1; pageNo++) {
+      PinnedPage pinned = bgBufMgr.readPage(file, pageNo);
+      pinned->insertRecord("cleaned");
+      pinned.markDirty();
+    }
+    bgBufMgr.startBackgroundWriter(num_bufs, std::chrono::milliseconds(1));
+    if (!waitForBackgroundWrites(bgBufMgr, num_bufs - 1)) {
+      PRINT_ERROR("ERROR :: DIRTY PAGES NOT WRITTEN IN THE BACKGROUND");
+    }
+    bgBufMgr.stopBackgroundWriter();
+    for (PageId pageNo = 1; pageNo <= num_bufs; pageNo++) {
+      if (file.readPage(pageNo).getRecord({pageNo, 2}) != "cleaned") {
+        PRINT_ERROR("ERROR :: PAGE WRITTEN IN THE BACKGROUND DID NOT MATCH");
+      }
+    }
+
+    const int evictwrites = bgBufMgr.getBufStats().evictwrites;
+    for (PageId pageNo = num_bufs + 2; pageNo <= 2 * num_bufs; pageNo++) {
+      PinnedPage pinned = bgBufMgr.readPage(file, pageNo);
+      pinned->insertRecord("cleaned");
+      pinned.markDirty();
+    }
+    if (evictwrites != 1 ||
+        bgBufMgr.getBufStats().evictwrites != evictwrites) {
+      PRINT_ERROR("ERROR :: CLEANED PAGES WRITTEN AGAIN ON EVICTION");
+    }
+    bgBufMgr.flushFile(file);
+    for (PageId pageNo = num_bufs + 1; pageNo <= 2 * num_bufs; pageNo++) {
+      if (file.readPage(pageNo).getRecord({pageNo, 2}) != "cleaned") {
+        PRINT_ERROR("ERROR :: FLUSHED PAGE DID NOT MATCH");
+      }
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 23 passed"
+            << "\n";
+}
+
+void test24() {
+  // Flushing a file whose dirty pages were read in descending order, in runs
+  // split by clean pages, writes each dirty page once and drops all the
+  // file's pages from the pool, leaving those of other files.
+  const std::string filename = "test.flush";
+  const std::string other_filename = "test.flushother";
+  const PageId num_pages = 40;
+  {
+    File file = File::create(filename);
+    File other_file = File::create(other_filename);
+    createNumberedFile(file, num_pages);
+    createNumberedFile(other_file, 1);
+    BufMgr flushBufMgr(num_pages + 1);
+    int dirty_pages = 0;
+    for (PageId pageNo = num_pages; pageNo >= 1; pageNo--) {
+      PinnedPage pinned = flushBufMgr.readPage(file, pageNo);
+      if (pageNo % 7 != 0 && pageNo % 11 != 0) {
+        pinned->insertRecord("flushed");
+        pinned.markDirty();
+        dirty_pages++;
+      }
+    }
+    {
+      PinnedPage pinned = flushBufMgr.readPage(other_file, 1);
+      pinned->insertRecord("kept");
+      pinned.markDirty();
+    }
+
+    flushBufMgr.clearBufStats();
+    flushBufMgr.flushFile(file);
+    if (flushBufMgr.getBufStats().diskwrites != dirty_pages) {
+      PRINT_ERROR("ERROR :: WRONG NUMBER OF PAGES FLUSHED");
+    }
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      Page page = file.readPage(pageNo);
+      const bool dirty = pageNo % 7 != 0 && pageNo % 11 != 0;
+      PageIterator iter = page.begin();
+      ++iter;
+      if ((iter != page.end()) != dirty ||
+          (dirty && page.getRecord({pageNo, 2}) != "flushed")) {
+        PRINT_ERROR("ERROR :: FLUSHED PAGE DID NOT MATCH");
+      }
+    }
+
+    flushBufMgr.clearBufStats();
+    flushBufMgr.readPage(other_file, 1).release();
+    flushBufMgr.readPage(file, 1).release();
+    if (flushBufMgr.getBufStats().diskreads != 1) {
+      PRINT_ERROR("ERROR :: FLUSHED FILE LEFT IN POOL OR OTHER FILE DROPPED");
+    }
+    Page other_page = other_file.readPage(1);
+    PageIterator other_iter = other_page.begin();
+    ++other_iter;
+    if (other_iter != other_page.end()) {
+      PRINT_ERROR("ERROR :: PAGE OF OTHER FILE FLUSHED");
+    }
+    flushBufMgr.flushFile(other_file);
+  }
+  File::remove(filename);
+  File::remove(other_filename);
+
+  std::cout << "Test 24 passed"
+            << "\n";
+}
+
+void test25() {
+  // Positional reads and writes on a file descriptor, out of order and
+  // vectored, leave holes and the end of the file reading as zeros.
+  const std::string filename = "test.posix";
+  {
+    std::unique_ptr<FileIO> io =
+        FileIO::open(FileBackend::POSIX, filename, true /* create_new */);
+    std::vector<Page> pages(5);
+    for (int k = 0; k < 5; k++) {
+      sprintf(tmpbuf, "%s Page %d", filename.c_str(), k);
+      pages[k].insertRecord(tmpbuf);
+    }
+    io->write(reinterpret_cast<const char *>(&pages[2]), Page::SIZE,
+              2 * Page::SIZE);
+    io->write(reinterpret_cast<const char *>(&pages[0]), Page::SIZE, 0);
+    iovec iov[2];
+    for (int k = 0; k < 2; k++) {
+      iov[k].iov_base = &pages[3 + k];
+      iov[k].iov_len = Page::SIZE;
+    }
+    io->writev(iov, 2, 3 * Page::SIZE);
+    if (io->size() != 5 * Page::SIZE) {
+      PRINT_ERROR("ERROR :: WRONG FILE SIZE AFTER POSITIONAL WRITES");
+    }
+
+    std::vector<Page> read_pages(6);
+    iovec read_iov[6];
+    for (int k = 0; k < 6; k++) {
+      read_iov[k].iov_base = &read_pages[k];
+      read_iov[k].iov_len = Page::SIZE;
+    }
+    io->readv(read_iov, 6, 0);
+    const std::vector<char> zeros(Page::SIZE, 0);
+    for (int k = 0; k < 6; k++) {
+      const char *data = reinterpret_cast<const char *>(&read_pages[k]);
+      if (k == 1 || k == 5) {
+        if (std::memcmp(data, zeros.data(), Page::SIZE) != 0) {
+          PRINT_ERROR("ERROR :: HOLE OR END OF FILE NOT READ AS ZEROS");
+        }
+        continue;
+      }
+      sprintf(tmpbuf, "%s Page %d", filename.c_str(), k);
+      if (read_pages[k].getRecord({0, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: POSITIONAL WRITE NOT READ BACK");
+      }
+    }
+    Page page;
+    io->read(reinterpret_cast<char *>(&page), Page::SIZE, 3 * Page::SIZE);
+    sprintf(tmpbuf, "%s Page %d", filename.c_str(), 3);
+    if (page.getRecord({0, 1}) != tmpbuf) {
+      PRINT_ERROR("ERROR :: POSITIONAL WRITE NOT READ BACK");
+    }
+  }
+  File::remove(filename);
+
+  // Files written through a file descriptor read the same through a stream.
+  const PageId num_pages = 10;
+  {
+    File file = File::create(filename, FileBackend::POSIX);
+    createNumberedFile(file, num_pages);
+  }
+  {
+    File file = File::open(filename, FileBackend::STREAM);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (file.readPage(pageNo).getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: PAGE NOT READ BACK THROUGH A STREAM");
+      }
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 25 passed"
+            << "\n";
+}
+
+void test26() {
+  // Direct I/O from aligned pages, and from buffers at odd addresses, offsets
+  // and lengths that have to be staged, read back the same; an unaligned
+  // write leaves the rest of the blocks it touches alone.
+  const std::string filename = "test.direct";
+  {
+    std::unique_ptr<FileIO> io =
+        FileIO::open(FileBackend::DIRECT, filename, true /* create_new */);
+    std::vector<Page> pages(4);
+    for (int k = 0; k < 4; k++) {
+      sprintf(tmpbuf, "%s Page %d", filename.c_str(), k);
+      pages[k].insertRecord(tmpbuf);
+    }
+    iovec iov[4];
+    for (int k = 0; k < 4; k++) {
+      iov[k].iov_base = &pages[k];
+      iov[k].iov_len = Page::SIZE;
+    }
+    io->writev(iov, 4, 0);
+
+    // Odd bytes straddling the first two pages, from an odd address.
+    std::vector<char> unaligned(Page::SIZE + 1);
+    char *const bytes = unaligned.data() + 1;
+    for (std::size_t k = 0; k < Page::SIZE; k++) {
+      bytes[k] = static_cast<char>(k * 7 + 3);
+    }
+    const std::uint64_t odd_offset = Page::SIZE - 100;
+    io->write(bytes, 300, odd_offset);
+    iovec odd_iov[2] = {{bytes + 300, 1000}, {bytes + 1300, 2001}};
+    io->writev(odd_iov, 2, odd_offset + 300);
+    std::unique_ptr<IOEngine> engine = IOEngine::create();
+    int error = 0;
+    engine->queueWrite(*io, bytes + 3301, 99, odd_offset + 3301,
+                       [&error](int result) { error = result; });
+    engine->wait();
+
+    std::vector<char> read_back(Page::SIZE + 1);
+    char *const read_bytes = read_back.data() + 1;
+    io->read(read_bytes, 1000, odd_offset);
+    iovec read_iov[2] = {{read_bytes + 1000, 1}, {read_bytes + 1001, 2399}};
+    io->readv(read_iov, 2, odd_offset + 1000);
+    if (error != 0 || std::memcmp(read_bytes, bytes, 3400) != 0) {
+      PRINT_ERROR("ERROR :: UNALIGNED DIRECT I/O DID NOT MATCH");
+    }
+
+    std::vector<Page> read_pages(4);
+    for (int k = 0; k < 4; k++) {
+      iov[k].iov_base = &read_pages[k];
+    }
+    io->readv(iov, 4, 0);
+    const char *const before = reinterpret_cast<const char *>(pages.data());
+    const char *const after = reinterpret_cast<const char *>(read_pages.data());
+    const std::uint64_t odd_end = odd_offset + 3400;
+    if (std::memcmp(after, before, odd_offset) != 0 ||
+        std::memcmp(after + odd_end, before + odd_end,
+                    4 * Page::SIZE - odd_end) != 0) {
+      PRINT_ERROR("ERROR :: UNALIGNED WRITE CHANGED OTHER BYTES");
+    }
+  }
+  File::remove(filename);
+
+  // Files written with direct I/O read the same through the page cache.
+  const PageId num_pages = 10;
+  {
+    File file = File::create(filename, FileBackend::DIRECT);
+    createNumberedFile(file, num_pages);
+  }
+  {
+    File file = File::open(filename, FileBackend::POSIX);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (file.readPage(pageNo).getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: PAGE WRITTEN WITH DIRECT I/O NOT READ BACK");
+      }
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 26 passed"
+            << "\n";
+}
+
+void test27() {
+  // Pages of a memory-mapped file, written as it grows past its mapping, are
+  // viewed and read back, also through views taken before it was remapped,
+  // and read the same through a file descriptor.
+  const std::string filename = "test.mmapfile";
+  const PageId num_pages = 300;
+  {
+    File file = File::create(filename, FileBackend::MMAP);
+    createNumberedFile(file, 1);
+    const PageView first_view = file.viewPage(1);
+    createNumberedFile(file, num_pages - 1);
+    sprintf(tmpbuf, "%s Page %u", filename.c_str(), 1);
+    if (first_view.viewRecord({1, 1}) != std::string(tmpbuf)) {
+      PRINT_ERROR("ERROR :: VIEW LOST WHEN THE FILE WAS REMAPPED");
+    }
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (file.viewPage(pageNo).getRecord({pageNo, 1}) != tmpbuf ||
+          file.readPage(pageNo).getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: MAPPED PAGE DID NOT MATCH");
+      }
+    }
+    file.deletePage(num_pages);
+    try {
+      file.viewPage(num_pages);
+      PRINT_ERROR("ERROR :: DELETED PAGE VIEWED");
+    } catch (const InvalidPageException &e) {
+    }
+  }
+  {
+    File file = File::open(filename, FileBackend::POSIX);
+    for (PageId pageNo = 1; pageNo < num_pages; pageNo++) {
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (file.readPage(pageNo).getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: MAPPED PAGE NOT READ BACK");
+      }
+    }
+    if (file.isPageUsed(num_pages)) {
+      PRINT_ERROR("ERROR :: DELETED PAGE STILL USED");
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 27 passed"
+            << "\n";
+}
+
+// Returns the header of a file as it is on disk.
+FileHeader readHeaderOnDisk(const std::string &filename) {
+  std::unique_ptr<FileIO> io =
+      FileIO::open(FileBackend::POSIX, filename, false /* create_new */);
+  FileHeader header;
+  io->read(reinterpret_cast<char *>(&header), sizeof(header), 0);
+  return header;
+}
+
+void test28() {
+  // All File objects for a file share one header in memory, which reaches the
+  // disk when flushed and is read back when the file is opened again.
+  const std::string filename = "test.header";
+  const PageId num_pages = 5;
+  FileHeader flushed_header;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, num_pages);
+    File same_file = File::open(filename);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      if (!same_file.isPageUsed(pageNo)) {
+        PRINT_ERROR("ERROR :: ALLOCATED PAGE NOT SHARED");
+      }
+    }
+    same_file.deletePage(2);
+    PageId expected = 1;
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      if ((*iter).page_number() != expected) {
+        PRINT_ERROR("ERROR :: DELETED PAGE NOT SHARED");
+      }
+      expected += expected == 1 ? 2 : 1;
+    }
+    if (expected != num_pages + 1 || file.allocatePage().page_number() != 2 ||
+        !same_file.isPageUsed(2)) {
+      PRINT_ERROR("ERROR :: REALLOCATED PAGE NOT SHARED");
+    }
+
+    file.flush();
+    flushed_header = readHeaderOnDisk(filename);
+    if (flushed_header.magic != FileHeader::MAGIC ||
+        flushed_header.version != FileHeader::VERSION) {
+      PRINT_ERROR("ERROR :: HEADER NOT FLUSHED");
+    }
+  }
+  if (!(readHeaderOnDisk(filename) == flushed_header)) {
+    PRINT_ERROR("ERROR :: FLUSHED HEADER CHANGED ON CLOSE");
+  }
+  {
+    File file = File::open(filename);
+    for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+      if (!file.isPageUsed(pageNo)) {
+        PRINT_ERROR("ERROR :: PAGE NOT USED AFTER REOPENING");
+      }
+    }
+    sprintf(tmpbuf, "%s Page %u", filename.c_str(), 3);
+    if (file.readPage(3).getRecord({3, 1}) != tmpbuf) {
+      PRINT_ERROR("ERROR :: PAGE DID NOT MATCH AFTER REOPENING");
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 28 passed"
+            << "\n";
+}
+
+void test29() {
+  // Each sync policy makes the pages written so far readable after the file
+  // is reopened, and only DATASYNC and FSYNC force them to the device.
+  const std::string filename = "test.sync";
+  const SyncPolicy policies[] = {SyncPolicy::NONE, SyncPolicy::FLUSH,
+                                 SyncPolicy::DATASYNC, SyncPolicy::FSYNC};
+  for (const SyncPolicy policy : policies) {
+    const PageId num_pages = 4;
+    {
+      File file = File::create(filename);
+      file.setSyncPolicy(policy);
+      createNumberedFile(file, num_pages);
+      file.sync();
+      const bool forced =
+          policy == SyncPolicy::DATASYNC || policy == SyncPolicy::FSYNC;
+      if (file.syncPolicy() != policy ||
+          file.deviceSyncs() != (forced ? 1 : 0)) {
+        PRINT_ERROR("ERROR :: SYNC POLICY NOT FOLLOWED");
+      }
+    }
+    {
+      File file = File::open(filename);
+      for (PageId pageNo = 1; pageNo <= num_pages; pageNo++) {
+        sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+        if (file.readPage(pageNo).getRecord({pageNo, 1}) != tmpbuf) {
+          PRINT_ERROR("ERROR :: SYNCED PAGE NOT READ BACK");
+        }
+      }
+    }
+    File::remove(filename);
+  }
+
+  // Every caller of GroupSync::sync() returns only after a run that started
+  // after it was called, while concurrent callers share runs.
+  GroupSync group;
+  std::atomic<int> started(0), finished(0);
+  std::atomic<bool> late(false);
+  const int num_threads = 8;
+  const int calls = 20;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&]() {
+      for (int k = 0; k < calls; k++) {
+        const int started_before = started;
+        group.sync([&]() {
+          ++started;
+          std::this_thread::sleep_for(std::chrono::microseconds(200));
+          ++finished;
+        });
+        if (finished <= started_before) late = true;
+      }
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+  if (late || group.runs() != static_cast<std::uint64_t>(finished) ||
+      finished > num_threads * calls) {
+    PRINT_ERROR("ERROR :: GROUP SYNC RETURNED BEFORE ITS RUN");
+  }
+
+  // A failed run is reported to the caller that ran it.
+  try {
+    group.sync([]() { throw FileIOException("test.group", "sync", EIO); });
+    PRINT_ERROR("ERROR :: FAILED SYNC NOT REPORTED");
+  } catch (const FileIOException &e) {
+  }
+
+  std::cout << "Test 29 passed"
+            << "\n";
+}
+
+void test30() {
+  // Vectored reads of a run of pages, clipped to the end of the file, and of
+  // a sorted list of pages, scattered into separate pages; free pages and
+  // pages past the end read as free.
+  const std::string filename = "test.readpages";
+  const PageId num_pages = 10;
+  {
+    File file = File::create(filename);
+    // Grow the file a page at a time, so that it ends after its last page.
+    file.setExtentPages(1);
+    createNumberedFile(file, num_pages);
+    file.deletePage(4);
+
+    std::vector<Page> pages(5);
+    Page *page_ptrs[5];
+    for (int k = 0; k < 5; k++) page_ptrs[k] = &pages[4 - k];
+    if (file.readPages(2, 5, page_ptrs) != 5) {
+      PRINT_ERROR("ERROR :: RUN NOT READ");
+    }
+    for (PageId k = 0; k < 5; k++) {
+      const PageId pageNo = 2 + k;
+      const Page &page = *page_ptrs[k];
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (pageNo == 4 ? page.page_number() != Page::INVALID_NUMBER
+                      : page.getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: PAGE OF RUN DID NOT MATCH");
+      }
+    }
+    if (file.readPages(num_pages - 1, 5, page_ptrs) != 2 ||
+        file.readPages(num_pages + 5, 5, page_ptrs) != 0) {
+      PRINT_ERROR("ERROR :: RUN NOT CLIPPED TO THE END OF THE FILE");
+    }
+
+    const PageId page_numbers[5] = {1, 3, 4, 5, num_pages + 2};
+    file.readPages(page_numbers, 5, page_ptrs);
+    for (int k = 0; k < 5; k++) {
+      const PageId pageNo = page_numbers[k];
+      const Page &page = *page_ptrs[k];
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (pageNo == 4 || pageNo > num_pages
+              ? page.page_number() != Page::INVALID_NUMBER
+              : page.getRecord({pageNo, 1}) != tmpbuf) {
+        PRINT_ERROR("ERROR :: LISTED PAGE DID NOT MATCH");
+      }
+    }
+
+    // Prefetching loads the used pages of such a list into the pool.
+    BufMgr scatterBufMgr(num_pages);
+    if (scatterBufMgr.prefetchPages(file, page_numbers, 5) != 3) {
+      PRINT_ERROR("ERROR :: WRONG NUMBER OF PAGES PREFETCHED");
+    }
+    scatterBufMgr.clearBufStats();
+    for (int k = 0; k < 5; k++) {
+      const PageId pageNo = page_numbers[k];
+      if (pageNo == 4 || pageNo > num_pages) continue;
+      sprintf(tmpbuf, "%s Page %u", filename.c_str(), pageNo);
+      if (scatterBufMgr.readPage(file, pageNo)->getRecord({pageNo, 1}) !=
+          tmpbuf) {
+        PRINT_ERROR("ERROR :: PREFETCHED PAGE DID NOT MATCH");
+      }
+    }
+    if (scatterBufMgr.getBufStats().diskreads != 0) {
+      PRINT_ERROR("ERROR :: PREFETCHED PAGE READ AGAIN");
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 30 passed"
+            << "\n";
+}
+
+void test31() {
+  // Pages read into and written from pages the caller owns, such as the
+  // frames of a pool, replace their whole contents; free pages are rejected
+  // both ways.
+  const std::string filename = "test.inplace";
+  const PageId num_pages = 4;
+  {
+    File file = File::create(filename);
+    createNumberedFile(file, num_pages);
+    std::vector<Page> frames(2);
+    for (int k = 0; k < 20; k++) {
+      frames[0].insertRecord("left over from an earlier page");
+    }
+    file.readPageInto(3, frames[0]);
+    sprintf(tmpbuf, "%s Page %u", filename.c_str(), 3);
+    PageIterator iter = frames[0].begin();
+    if (frames[0].page_number() != 3 || *iter != tmpbuf ||
+        ++iter != frames[0].end()) {
+      PRINT_ERROR("ERROR :: PAGE NOT READ IN PLACE");
+    }
+
+    frames[0].insertRecord("written in place");
+    file.writePageFrom(frames[0]);
+    file.readPageInto(1, frames[1]);
+    file.readPageInto(3, frames[1]);
+    if (frames[1].getRecord({3, 2}) != "written in place" ||
+        std::memcmp(&frames[0], &frames[1], Page::SIZE) != 0) {
+      PRINT_ERROR("ERROR :: PAGE NOT WRITTEN IN PLACE");
+    }
+
+    file.deletePage(2);
+    try {
+      file.readPageInto(2, frames[1]);
+      PRINT_ERROR("ERROR :: FREE PAGE READ IN PLACE");
+    } catch (const InvalidPageException &e) {
+    }
+    try {
+      file.writePageFrom(Page());
+      PRINT_ERROR("ERROR :: PAGE NEVER ALLOCATED WRITTEN IN PLACE");
+    } catch (const InvalidPageException &e) {
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 31 passed"
+            << "\n";
+}
+
+void test32() {
+  // Views of records, binary ones included, point into the page and have the
+  // same bytes as copies of them, on pages in memory and viewed in files.
+  const std::string filename = "test.recordview";
+  const std::string records[] = {std::string("a\0b\0c", 5), "", "plain",
+                                 std::string(1000, '\0')};
+  Page page;
+  std::vector<RecordId> rids;
+  for (const std::string &record : records) {
+    rids.push_back(page.insertRecord(record));
+  }
+  page.deleteRecord(rids[2]);
+  const char *const page_begin = reinterpret_cast<const char *>(&page);
+  for (std::size_t k = 0; k < rids.size(); k++) {
+    if (k == 2) continue;
+    const RecordView view = page.viewRecord(rids[k]);
+    if (view != records[k] || view.str() != page.getRecord(rids[k]) ||
+        view.size() != records[k].size() ||
+        (!view.empty() &&
+         (view.data() < page_begin || view.end() > page_begin + Page::SIZE))) {
+      PRINT_ERROR("ERROR :: RECORD VIEW DID NOT MATCH");
+    }
+  }
+  try {
+    page.viewRecord(rids[2]);
+    PRINT_ERROR("ERROR :: DELETED RECORD VIEWED");
+  } catch (const InvalidRecordException &e) {
+  }
+
+  {
+    File file = File::create(filename);
+    Page file_page = file.allocatePage();
+    std::vector<RecordId> file_rids;
+    for (const std::string &record : records) {
+      file_rids.push_back(file_page.insertRecord(record));
+    }
+    file.writePage(file_page);
+    const PageView page_view = file.viewPage(file_page.page_number());
+    for (std::size_t k = 0; k < file_rids.size(); k++) {
+      if (page_view.viewRecord(file_rids[k]) != records[k] ||
+          page_view.getRecord(file_rids[k]) != records[k]) {
+        PRINT_ERROR("ERROR :: RECORD VIEW OF FILE PAGE DID NOT MATCH");
+      }
+    }
+  }
+  File::remove(filename);
+
+  std::cout << "Test 32 passed"
+            << "\n";
+}
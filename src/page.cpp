@@ -9,6 +9,7 @@
 #include "page.h"
 
 #include <cassert>
+#include <cstring>
 
 #include "exceptions/insufficient_space_exception.h"
 #include "exceptions/invalid_record_exception.h"
@@ -18,49 +19,104 @@
 
 namespace badgerdb {
 
+namespace {
+
+/**
+ * Slot of version 1 pages.
+ */
+struct UnpackedPageSlot {
+  bool used;
+  std::uint16_t item_offset;
+  std::uint16_t item_length;
+};
+
+static_assert(sizeof(UnpackedPageSlot) == 6,
+              "Slots of version 1 pages took six bytes.");
+
+}  // namespace
+
 Page::Page() { initialize(); }
 
 void Page::initialize() {
-  header_.free_space_lower_bound = 0;
+  header_.fragmented_bytes = 0;
+  header_.current_format = 1;
   header_.free_space_upper_bound = DATA_SIZE;
   header_.num_slots = 0;
-  header_.num_free_slots = 0;
+  header_.first_free_slot = INVALID_SLOT;
   header_.current_page_number = INVALID_NUMBER;
   header_.next_page_number = INVALID_NUMBER;
-  data_.assign(DATA_SIZE, char());
+  std::memset(data_, 0, DATA_SIZE);
 }
 
 RecordId Page::insertRecord(const std::string &record_data) {
-  if (!hasSpaceForRecord(record_data)) {
+  RecordId record_id;
+  if (tryInsertRecord(record_data, record_id) != Status::OK) {
     throw InsufficientSpaceException(page_number(), record_data.length(),
                                      getFreeSpace());
   }
+  return record_id;
+}
+
+Status Page::tryInsertRecord(const std::string &record_data,
+                             RecordId &record_id) {
+  if (!hasSpaceForRecord(record_data)) {
+    return Status::INSUFFICIENT_SPACE;
+  }
+  const std::size_t slot_size =
+      header_.first_free_slot == INVALID_SLOT ? sizeof(PageSlot) : 0;
+  if (record_data.length() + slot_size > getContiguousFreeSpace()) {
+    compact();
+  }
   const SlotId slot_number = getAvailableSlot();
   insertRecordInSlot(slot_number, record_data);
-  return {page_number(), slot_number};
+  record_id = {page_number(), slot_number};
+  return Status::OK;
 }
 
 std::string Page::getRecord(const RecordId &record_id) const {
+  return viewRecord(record_id).str();
+}
+
+RecordView Page::viewRecord(const RecordId &record_id) const {
   validateRecordId(record_id);
   const PageSlot *slot = getSlot(record_id.slot_number);
-  return data_.substr(slot->item_offset, slot->item_length);
+  return RecordView(data_ + slot->item_offset, slot->item_length);
 }
 
 void Page::updateRecord(const RecordId &record_id,
                         const std::string &record_data) {
+  if (tryUpdateRecord(record_id, record_data) != Status::OK) {
+    const PageSlot *slot = getSlot(record_id.slot_number);
+    throw InsufficientSpaceException(page_number(), record_data.length(),
+                                     getFreeSpace() + slot->item_length);
+  }
+}
+
+Status Page::tryUpdateRecord(const RecordId &record_id,
+                             const std::string &record_data) {
   validateRecordId(record_id);
-  const PageSlot *slot = getSlot(record_id.slot_number);
+  PageSlot *slot = getSlot(record_id.slot_number);
+  const std::size_t new_length = record_data.length();
+  if (new_length <= slot->item_length) {
+    // Shrink in place; the bytes no longer used are fragmented space.
+    std::memcpy(data_ + slot->item_offset, record_data.data(), new_length);
+    std::memset(data_ + slot->item_offset + new_length, 0,
+                slot->item_length - new_length);
+    header_.fragmented_bytes += slot->item_length - new_length;
+    slot->item_length = static_cast<std::uint16_t>(new_length);
+    return Status::OK;
+  }
   const std::size_t free_space_after_delete =
       getFreeSpace() + slot->item_length;
-  if (record_data.length() > free_space_after_delete) {
-    throw InsufficientSpaceException(page_number(), record_data.length(),
-                                     free_space_after_delete);
+  if (new_length > free_space_after_delete) {
+    return Status::INSUFFICIENT_SPACE;
   }
   // We have to disallow slot compaction here because we're going to place the
   // record data in the same slot, and compaction might delete the slot if we
   // permit it.
   deleteRecord(record_id, false /* allow_slot_compaction */);
   insertRecordInSlot(record_id.slot_number, record_data);
+  return Status::OK;
 }
 
 void Page::deleteRecord(const RecordId &record_id) {
@@ -71,97 +127,143 @@ void Page::deleteRecord(const RecordId &record_id,
                         const bool allow_slot_compaction) {
   validateRecordId(record_id);
   PageSlot *slot = getSlot(record_id.slot_number);
-  data_.replace(slot->item_offset, slot->item_length, slot->item_length, '\0');
-
-  // Compact the data by removing the hole left by this record (if necessary).
-  std::uint16_t move_offset = slot->item_offset;
-  std::size_t move_bytes = 0;
-  for (SlotId i = 1; i <= header_.num_slots; ++i) {
-    PageSlot *other_slot = getSlot(i);
-    if (other_slot->used && other_slot->item_offset < slot->item_offset) {
-      if (other_slot->item_offset < move_offset) {
-        move_offset = other_slot->item_offset;
-      }
-      move_bytes += other_slot->item_length;
-      // Update the slot for the other data to reflect the soon-to-be-new
-      // location.
-      other_slot->item_offset += slot->item_length;
-    }
-  }
-  // If we have data to move, shift it to the right.
-  if (move_bytes > 0) {
-    const std::string &data_to_move = data_.substr(move_offset, move_bytes);
-    data_.replace(move_offset + slot->item_length, move_bytes, data_to_move);
+  std::memset(data_ + slot->item_offset, 0, slot->item_length);
+  if (slot->item_offset == header_.free_space_upper_bound) {
+    // The lowest record: its bytes join the contiguous free space.
+    header_.free_space_upper_bound += slot->item_length;
+  } else {
+    header_.fragmented_bytes += slot->item_length;
   }
-  header_.free_space_upper_bound += slot->item_length;
 
-  // Mark slot as unused.
-  slot->used = false;
-  slot->item_offset = 0;
-  slot->item_length = 0;
-  ++header_.num_free_slots;
+  linkFreeSlot(record_id.slot_number);
 
   if (allow_slot_compaction && record_id.slot_number == header_.num_slots) {
     // Last slot in the list, so we need to free any unused slots that are at
-    // the end of the slot list.
-    int num_slots_to_delete = 1;
-    for (SlotId i = 1; i < header_.num_slots; ++i) {
-      // Traverse list backwards, looking for unused slots.
-      const PageSlot *other_slot = getSlot(header_.num_slots - i);
-      if (!other_slot->used) {
-        ++num_slots_to_delete;
-      } else {
-        // Stop at the first used slot we find, since we can't move used
-        // slots without affecting record IDs.
-        break;
-      }
+    // the end of the slot list.  Stop at the first used slot we find, since
+    // we can't move used slots without affecting record IDs.
+    const SlotId old_num_slots = header_.num_slots;
+    while (header_.num_slots > 0 && !getSlot(header_.num_slots)->used) {
+      unlinkFreeSlot(header_.num_slots);
+      --header_.num_slots;
     }
-    header_.num_slots -= num_slots_to_delete;
-    header_.num_free_slots -= num_slots_to_delete;
-    header_.free_space_lower_bound -= sizeof(PageSlot) * num_slots_to_delete;
+    // Clear the dropped slots, which now lie in the free space.
+    std::memset(data_ + getSlotArrayEnd(), 0,
+                (old_num_slots - header_.num_slots) * sizeof(PageSlot));
   }
 }
 
+void Page::compact() {
+  // Pack the records, in slot order, at the end of a scratch copy of the data
+  // area, then copy the packed part back.
+  char packed[DATA_SIZE];
+  std::uint16_t end = DATA_SIZE;
+  for (SlotId i = 1; i <= header_.num_slots; ++i) {
+    PageSlot *slot = getSlot(i);
+    if (!slot->used) continue;
+    end -= slot->item_length;
+    std::memcpy(packed + end, data_ + slot->item_offset, slot->item_length);
+    slot->item_offset = end;
+  }
+  std::memset(data_ + header_.free_space_upper_bound, 0,
+              end - header_.free_space_upper_bound);
+  std::memcpy(data_ + end, packed + end, DATA_SIZE - end);
+  header_.free_space_upper_bound = end;
+  header_.fragmented_bytes = 0;
+}
+
 bool Page::hasSpaceForRecord(const std::string &record_data) const {
   std::size_t record_size = record_data.length();
-  if (header_.num_free_slots == 0) {
+  if (header_.first_free_slot == INVALID_SLOT) {
     record_size += sizeof(PageSlot);
   }
   return record_size <= getFreeSpace();
 }
 
 PageSlot *Page::getSlot(const SlotId slot_number) {
-  return reinterpret_cast<PageSlot *>(
-      &data_[(slot_number - 1) * sizeof(PageSlot)]);
+  return reinterpret_cast<PageSlot *>(data_ +
+                                      (slot_number - 1) * sizeof(PageSlot));
 }
 
 const PageSlot *Page::getSlot(const SlotId slot_number) const {
   return reinterpret_cast<const PageSlot *>(
-      &data_[(slot_number - 1) * sizeof(PageSlot)]);
+      data_ + (slot_number - 1) * sizeof(PageSlot));
 }
 
 SlotId Page::getAvailableSlot() {
-  SlotId slot_number = INVALID_SLOT;
-  if (header_.num_free_slots > 0) {
-    // Have an allocated but unused slot that we can reuse.
-    for (SlotId i = 1; i <= header_.num_slots; ++i) {
-      const PageSlot *slot = getSlot(i);
-      if (!slot->used) {
-        // We don't decrement the number of free slots until someone
-        // actually puts data in the slot.
-        slot_number = i;
-        break;
-      }
-    }
-  } else {
+  if (header_.first_free_slot == INVALID_SLOT) {
     // Have to allocate a new slot.
-    slot_number = header_.num_slots + 1;
     ++header_.num_slots;
-    ++header_.num_free_slots;
-    header_.free_space_lower_bound = sizeof(PageSlot) * header_.num_slots;
+    linkFreeSlot(header_.num_slots);
+  }
+  // We don't take the slot off the chain until someone actually puts data in
+  // the slot.
+  assert(header_.first_free_slot != INVALID_SLOT);
+  return header_.first_free_slot;
+}
+
+void Page::linkFreeSlot(const SlotId slot_number) {
+  PageSlot *slot = getSlot(slot_number);
+  slot->used = false;
+  slot->item_offset = header_.first_free_slot;
+  slot->item_length = INVALID_SLOT;
+  if (header_.first_free_slot != INVALID_SLOT) {
+    getSlot(header_.first_free_slot)->item_length = slot_number;
+  }
+  header_.first_free_slot = slot_number;
+}
+
+void Page::unlinkFreeSlot(const SlotId slot_number) {
+  PageSlot *slot = getSlot(slot_number);
+  const SlotId next = slot->item_offset;
+  const SlotId previous = slot->item_length;
+  if (previous != INVALID_SLOT) {
+    getSlot(previous)->item_offset = next;
+  } else {
+    header_.first_free_slot = next;
+  }
+  if (next != INVALID_SLOT) {
+    getSlot(next)->item_length = previous;
+  }
+  slot->item_offset = 0;
+  slot->item_length = 0;
+}
+
+void Page::rebuildFreeSlotChain() {
+  header_.first_free_slot = INVALID_SLOT;
+  for (SlotId i = header_.num_slots; i >= 1; --i) {
+    if (!getSlot(i)->used) {
+      linkFreeSlot(i);
+    }
   }
-  assert(slot_number != INVALID_SLOT);
-  return slot_number;
+}
+
+void Page::convertFromVersion1() {
+  if (header_.num_slots == 0) {
+    initialize();
+    return;
+  }
+  // Version 1 pages were compacted on every delete.
+  header_.fragmented_bytes = 0;
+  header_.current_format = 1;
+  packSlots();
+  rebuildFreeSlotChain();
+}
+
+void Page::packSlots() {
+  // Slots only shrink, so each one can be packed in place in slot order.
+  const SlotId num_slots = header_.num_slots;
+  for (SlotId i = 1; i <= num_slots; ++i) {
+    UnpackedPageSlot old_slot;
+    std::memcpy(&old_slot, data_ + (i - 1) * sizeof(UnpackedPageSlot),
+                sizeof(old_slot));
+    PageSlot slot = PageSlot();
+    slot.used = old_slot.used;
+    slot.item_offset = old_slot.item_offset;
+    slot.item_length = old_slot.item_length;
+    *getSlot(i) = slot;
+  }
+  std::memset(data_ + getSlotArrayEnd(), 0,
+              num_slots * (sizeof(UnpackedPageSlot) - sizeof(PageSlot)));
 }
 
 void Page::insertRecordInSlot(const SlotId slot_number,
@@ -174,12 +276,15 @@ void Page::insertRecordInSlot(const SlotId slot_number,
     throw SlotInUseException(page_number(), slot_number);
   }
   const int record_length = record_data.length();
+  if (static_cast<std::size_t>(record_length) > getContiguousFreeSpace()) {
+    compact();
+  }
+  unlinkFreeSlot(slot_number);
   slot->used = true;
   slot->item_length = record_length;
   slot->item_offset = header_.free_space_upper_bound - record_length;
   header_.free_space_upper_bound = slot->item_offset;
-  --header_.num_free_slots;
-  data_.replace(slot->item_offset, slot->item_length, record_data);
+  std::memcpy(data_ + slot->item_offset, record_data.data(), record_length);
 }
 
 void Page::validateRecordId(const RecordId &record_id) const {
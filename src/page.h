@@ -14,6 +14,8 @@
 #include <memory>
 #include <string>
 
+#include "record_view.h"
+#include "status.h"
 #include "types.h"
 
 namespace badgerdb {
@@ -26,10 +28,18 @@ namespace badgerdb {
  */
 struct PageHeader {
   /**
-   * Lower bound of the free space.  This is the offset of the first unused byte
-   * after the slot array.
+   * Bytes of deleted or shrunk records between free_space_upper_bound and the
+   * end of the page, free but not contiguous until the page is compacted.
    */
-  std::uint16_t free_space_lower_bound;
+  std::uint16_t fragmented_bytes : 15;
+
+  /**
+   * Set in every page in the current format.  Pages of version 1 files kept
+   * the free space lower bound, the end of the slot array, in these two
+   * bytes, which never reaches 1 << 15; File converts them when it reads
+   * them (see Page::convertFromVersion1()).
+   */
+  std::uint16_t current_format : 1;
 
   /**
    * Upper bound of the free space.  This is the offset of the last unused byte
@@ -45,17 +55,25 @@ struct PageHeader {
   SlotId num_slots;
 
   /**
-   * Number of slots allocated but not in use.
+   * First slot of the chain of slots allocated but not in use, or
+   * Page::INVALID_SLOT if every slot holds a record.  The chain runs through
+   * the free slots themselves (see PageSlot), so that a free slot is found
+   * and taken in constant time.  Pages of version 1 files kept the number of
+   * free slots here instead.
    */
-  SlotId num_free_slots;
+  SlotId first_free_slot;
 
   /**
-   * Number of the page within the file.
+   * Number of the page within the file, or INVALID_NUMBER for a free page.
+   * Filled in by File from its PageDirectory when the page is read, so that
+   * pages allocated but never written read as used.
    */
   PageId current_page_number;
 
   /**
-   * Number of the next used page in the file.
+   * Number of the next used page in the file, as of when the page was read.
+   * Filled in by File from its PageDirectory; the value on disk is unused
+   * since format version 2.
    */
   PageId next_page_number;
 
@@ -66,33 +84,47 @@ struct PageHeader {
    * @return  True if the other header is equal to this one.
    */
   bool operator==(const PageHeader &rhs) const {
-    return num_slots == rhs.num_slots && num_free_slots == rhs.num_free_slots &&
+    return num_slots == rhs.num_slots &&
+           first_free_slot == rhs.first_free_slot &&
            current_page_number == rhs.current_page_number &&
            next_page_number == rhs.next_page_number;
   }
 };
 
+static_assert(sizeof(PageHeader) == 16,
+              "A PageHeader must keep the layout of version 1 pages.");
+
 /**
  * @brief Slot metadata that tracks where a record is in the data space.
+ *
+ * Packed into one 32-bit word, allocated from the least significant bit:
+ * item_offset in bits 0-14, used in bit 15 and item_length in bits 16-31, a
+ * whole half of the word.  Fifteen bits hold any offset within a page, and
+ * any slot number.  Pages of version 1 files had six-byte slots: a bool used
+ * followed by 16-bit item_offset and item_length.
  */
 struct PageSlot {
   /**
-   * Whether the slot currently holds data.  May be false if this slot's
-   * record has been deleted after insertion.
+   * Offset of the data item in the page.  In a free slot, the next slot of
+   * the free slot chain, or Page::INVALID_SLOT at its end.
    */
-  bool used;
+  std::uint32_t item_offset : 15;
 
   /**
-   * Offset of the data item in the page.
+   * Whether the slot currently holds data.  May be false if this slot's
+   * record has been deleted after insertion.
    */
-  std::uint16_t item_offset;
+  std::uint32_t used : 1;
 
   /**
-   * Length of the data item in this slot.
+   * Length of the data item in this slot.  In a free slot, the previous slot
+   * of the free slot chain, or Page::INVALID_SLOT at its start.
    */
-  std::uint16_t item_length;
+  std::uint32_t item_length : 16;
 };
 
+static_assert(sizeof(PageSlot) == 4, "A PageSlot must be packed in 4 bytes.");
+
 class PageIterator;
 
 /**
@@ -103,6 +135,10 @@ class PageIterator;
  * slots and identified by a RecordId.  Although a record's actual contents may
  * be moved on the page, accessing a record by its slot is consistent.
  *
+ * A Page object is exactly the SIZE bytes of the page as laid out on disk,
+ * header first, aligned to SIZE, so that it can be read into and written
+ * from as it is and an array of pages is one contiguous block.
+ *
  * @warning This class is not threadsafe.
  */
 class Page {
@@ -141,6 +177,17 @@ class Page {
    */
   RecordId insertRecord(const std::string &record_data);
 
+  /**
+   * Non-throwing variant of insertRecord(), for callers to whom a full page is
+   * the normal signal to move on to another page.
+   *
+   * @param record_data  Bytes that compose the record.
+   * @param record_id    Set to the ID of the newly inserted record.
+   * @return  Status::INSUFFICIENT_SPACE if the page cannot hold the record,
+   *          Status::OK otherwise.
+   */
+  Status tryInsertRecord(const std::string &record_data, RecordId &record_id);
+
   /**
    * Returns the record with the given ID.  Returned data is a copy of what is
    * stored on the page; use updateRecord to change it.
@@ -151,6 +198,17 @@ class Page {
    */
   std::string getRecord(const RecordId &record_id) const;
 
+  /**
+   * Returns the record with the given ID in place, without copying it.  The
+   * view is invalidated by any change to the page; see RecordView.
+   *
+   * @param record_id  ID of the record to return.
+   * @return  View of the record.
+   * @throws  InvalidRecordException  If the record ID is not valid for this
+   *                                  page.
+   */
+  RecordView viewRecord(const RecordId &record_id) const;
+
   /**
    * Updates the record with the given ID, replacing its data with a new
    * version.  This is equivalent to deleting the old record and inserting a
@@ -162,9 +220,24 @@ class Page {
   void updateRecord(const RecordId &record_id, const std::string &record_data);
 
   /**
-   * Deletes the record with the given ID.  Page is compacted upon delete to
-   * ensure that data of all records is contiguous.  Slot array is compacted if
-   * the slot deleted is at the end of the slot array.
+   * Non-throwing variant of updateRecord() for the out-of-space case.  The
+   * record is left unchanged if it does not fit.
+   *
+   * @param record_id   ID of record to update.
+   * @param record_data Updated bytes that compose the record.
+   * @return  Status::INSUFFICIENT_SPACE if the page cannot hold the new
+   *          version, Status::OK otherwise.
+   * @throws  InvalidRecordException  Thrown if the ID has a bad page or slot
+   *                                  number.
+   */
+  Status tryUpdateRecord(const RecordId &record_id,
+                         const std::string &record_data);
+
+  /**
+   * Deletes the record with the given ID.  Its bytes become fragmented free
+   * space, reclaimed by compacting the page once an insert or update needs
+   * contiguous space.  Slot array is compacted if the slot deleted is at the
+   * end of the slot array.
    *
    * @param record_id   ID of the record to delete.
    */
@@ -179,12 +252,13 @@ class Page {
   bool hasSpaceForRecord(const std::string &record_data) const;
 
   /**
-   * Returns this page's free space in bytes.
+   * Returns this page's free space in bytes, including fragmented space that
+   * compaction would make contiguous.
    *
    * @return  Free space in bytes.
    */
   std::uint16_t getFreeSpace() const {
-    return header_.free_space_upper_bound - header_.free_space_lower_bound;
+    return getContiguousFreeSpace() + header_.fragmented_bytes;
   }
 
   /**
@@ -241,8 +315,8 @@ class Page {
   }
 
   /**
-   * Deletes the record with the given ID.  Page is compacted upon delete to
-   * ensure that data of all records is contiguous.  Slot array is compacted if
+   * Deletes the record with the given ID, leaving its bytes as fragmented
+   * space unless they are the lowest on the page.  Slot array is compacted if
    * the slot deleted is at the end of the slot array and
    * <allow_slot_compaction> is set.
    *
@@ -253,6 +327,27 @@ class Page {
   void deleteRecord(const RecordId &record_id,
                     const bool allow_slot_compaction);
 
+  /**
+   * Returns the offset of the first byte after the slot array, the lower
+   * bound of the contiguous free space.
+   */
+  std::uint16_t getSlotArrayEnd() const {
+    return static_cast<std::uint16_t>(header_.num_slots * sizeof(PageSlot));
+  }
+
+  /**
+   * Returns the free space between the slot array and the records.
+   */
+  std::uint16_t getContiguousFreeSpace() const {
+    return header_.free_space_upper_bound - getSlotArrayEnd();
+  }
+
+  /**
+   * Moves all records to the end of the page, turning the fragmented space
+   * into contiguous free space.  Takes time linear in the size of the page.
+   */
+  void compact();
+
   /**
    * Returns the slot with the given number.  This method will return
    * unallocated slots if requested; it is up to the caller to ensure they
@@ -274,13 +369,14 @@ class Page {
   const PageSlot *getSlot(const SlotId slot_number) const;
 
   /**
-   * Returns the slot number of an available slot.  If no slots are available
-   * to be reused, allocates a new slot.  Updates available slot count in the
-   * header metadata, but does not mark returned slot as used.  If a new slot is
-   * allocated, updates the free space lower bound.
+   * Returns the slot number of an available slot, in constant time: the
+   * first of the free slot chain.  If no slots are available to be reused,
+   * allocates a new slot, which extends the slot array into the contiguous
+   * free space, and adds it to the chain.  Does not mark returned slot as
+   * used.
    *
-   * Callers are responsible for making sure there is enough space to allocate a
-   * new slot before calling this method.
+   * Callers are responsible for making sure there is enough contiguous space to
+   * allocate a new slot before calling this method.
    *
    * Since the returned slot is not marked as used, callers must take care to
    * fill the slot or mark it used before someone else calls this method.
@@ -289,9 +385,45 @@ class Page {
    */
   SlotId getAvailableSlot();
 
+  /**
+   * Marks a slot as free and puts it at the front of the free slot chain.
+   *
+   * @param slot_number   Number of the slot, which must not be in the chain.
+   */
+  void linkFreeSlot(const SlotId slot_number);
+
+  /**
+   * Takes a free slot out of the free slot chain and clears it.
+   *
+   * @param slot_number   Number of the slot, which must be in the chain.
+   */
+  void unlinkFreeSlot(const SlotId slot_number);
+
+  /**
+   * Rebuilds the free slot chain from the used flags of the slots, lowest
+   * free slot first.
+   */
+  void rebuildFreeSlotChain();
+
+  /**
+   * Rewrites the six-byte slot array of a version 1 page in the packed
+   * PageSlot format.  Records stay where they are; the space given up by the
+   * slot array becomes contiguous free space.
+   */
+  void packSlots();
+
+  /**
+   * Converts a page read from a version 1 file, whose current_format bit is
+   * clear, to the current format in place.  A page with no slots, such as
+   * one that was never written and reads as zeros, becomes an empty page.
+   * The page and next page numbers are left for File to fill in.
+   */
+  void convertFromVersion1();
+
   /**
    * Inserts record data into the given slot.  The slot should not be currently
-   * in use.  <slot_number> must be less than <header_.num_slots>.
+   * in use.  <slot_number> must be less than <header_.num_slots>.  Compacts
+   * the page first if the record does not fit in the contiguous free space.
    *
    * Callers are responsible for making sure there is enough space to hold the
    * record before calling this method.
@@ -323,17 +455,17 @@ class Page {
   bool isUsed() const { return page_number() != INVALID_NUMBER; }
 
   /**
-   * Header metadata.
+   * Header metadata.  Its alignment is that of the whole page.
    */
-  PageHeader header_;
+  alignas(SIZE) PageHeader header_;
 
   /**
    * Data stored on the page.  Includes bookkeeping information about slots as
    * well as actual content.
    */
+  char data_[DATA_SIZE];
 
-  std::string data_;
-
+  friend class BufMgr;
   friend class File;
   friend class PageIterator;
   friend class PageTest;
@@ -343,5 +475,9 @@ class Page {
 static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0, "Page must have some space to hold data.");
+static_assert(sizeof(Page) == Page::SIZE && alignof(Page) == Page::SIZE,
+              "A Page must be exactly one aligned page of memory.");
+static_assert(Page::DATA_SIZE < (1 << 15),
+              "Offsets must fit in the bits of a PageSlot.");
 
 }  // namespace badgerdb
@@ -0,0 +1,175 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "page_directory.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace badgerdb {
+
+const std::size_t PageDirectory::HEADER_AREA_OFFSET;
+const std::size_t PageDirectory::LINK_SIZE;
+const PageId PageDirectory::HEADER_BITS;
+const PageId PageDirectory::DIRECTORY_PAGE_BITS;
+const std::size_t PageDirectory::HEADER_WORDS;
+const std::size_t PageDirectory::DIRECTORY_PAGE_WORDS;
+
+PageDirectory::PageDirectory() : bits_(HEADER_WORDS, 0), free_hint_(1) {
+  // The header is never handed out.
+  bits_[0] = 1;
+}
+
+void PageDirectory::loadHeaderArea(const char *area) {
+  std::uint32_t count;
+  PageId first;
+  std::memcpy(&count, area, sizeof(count));
+  std::memcpy(&first, area + sizeof(count), sizeof(first));
+  pages_.assign(count, PageId(Page::INVALID_NUMBER));
+  if (count > 0) {
+    pages_[0] = first;
+  }
+  dirty_.assign(count, false);
+  bits_.assign(capacity() / 64, 0);
+  std::memcpy(bits_.data(), area + LINK_SIZE, HEADER_WORDS * 8);
+  free_hint_ = 1;
+}
+
+void PageDirectory::storeHeaderArea(char *area) const {
+  const std::uint32_t count = static_cast<std::uint32_t>(pages_.size());
+  const PageId first = count > 0 ? pages_[0] : Page::INVALID_NUMBER;
+  std::memset(area, 0, LINK_SIZE);
+  std::memcpy(area, &count, sizeof(count));
+  std::memcpy(area + sizeof(count), &first, sizeof(first));
+  std::memcpy(area + LINK_SIZE, bits_.data(), HEADER_WORDS * 8);
+}
+
+void PageDirectory::loadDirectoryPage(const std::size_t index,
+                                      const char *page) {
+  if (index + 1 < pages_.size()) {
+    std::memcpy(&pages_[index + 1], page, sizeof(PageId));
+  }
+  std::memcpy(&bits_[HEADER_WORDS + index * DIRECTORY_PAGE_WORDS],
+              page + LINK_SIZE, DIRECTORY_PAGE_WORDS * 8);
+  free_hint_ = 1;
+}
+
+void PageDirectory::storeDirectoryPage(const std::size_t index,
+                                       char *page) const {
+  const PageId next =
+      index + 1 < pages_.size() ? pages_[index + 1] : Page::INVALID_NUMBER;
+  std::memset(page, 0, LINK_SIZE);
+  std::memcpy(page, &next, sizeof(next));
+  std::memcpy(page + LINK_SIZE,
+              &bits_[HEADER_WORDS + index * DIRECTORY_PAGE_WORDS],
+              DIRECTORY_PAGE_WORDS * 8);
+}
+
+std::vector<std::size_t> PageDirectory::takeDirtyPages() {
+  std::vector<std::size_t> dirty;
+  for (std::size_t i = 0; i < dirty_.size(); ++i) {
+    if (dirty_[i]) {
+      dirty.push_back(i);
+      dirty_[i] = false;
+    }
+  }
+  return dirty;
+}
+
+void PageDirectory::addDirectoryPage(const PageId page_number) {
+  if (!dirty_.empty()) {
+    // The last directory page now links to the new one.
+    dirty_.back() = true;
+  }
+  pages_.push_back(page_number);
+  dirty_.push_back(true);
+  bits_.resize(bits_.size() + DIRECTORY_PAGE_WORDS, 0);
+  if (page_number < capacity()) {
+    bits_[page_number / 64] |= std::uint64_t(1) << (page_number % 64);
+  }
+}
+
+void PageDirectory::setUsed(const PageId page_number, const bool used) {
+  const std::uint64_t bit = std::uint64_t(1) << (page_number % 64);
+  if (used) {
+    bits_[page_number / 64] |= bit;
+  } else {
+    bits_[page_number / 64] &= ~bit;
+    free_hint_ = std::min(free_hint_, page_number);
+  }
+  if (page_number >= HEADER_BITS) {
+    dirty_[(page_number - HEADER_BITS) / DIRECTORY_PAGE_BITS] = true;
+  }
+}
+
+PageId PageDirectory::findFree(const PageId num_pages) {
+  for (std::size_t word = free_hint_ / 64; word * 64 < num_pages; ++word) {
+    const std::uint64_t free_bits = ~bits_[word];
+    if (free_bits == 0) {
+      continue;
+    }
+    const PageId page_number =
+        static_cast<PageId>(word * 64 + __builtin_ctzll(free_bits));
+    if (page_number >= num_pages) {
+      break;
+    }
+    free_hint_ = page_number;
+    return page_number;
+  }
+  free_hint_ = std::max(free_hint_, num_pages);
+  return Page::INVALID_NUMBER;
+}
+
+PageId PageDirectory::findFreeRun(const PageId count,
+                                  const PageId num_pages) const {
+  PageId run_start = free_hint_;
+  PageId page_number = free_hint_;
+  while (page_number < num_pages) {
+    if (page_number % 64 == 0 && bits_[page_number / 64] == ~std::uint64_t(0)) {
+      // Skip whole words of used pages.
+      page_number += 64;
+      run_start = page_number;
+    } else if (testBit(page_number)) {
+      run_start = ++page_number;
+    } else if (++page_number - run_start == count) {
+      return run_start;
+    }
+  }
+  return Page::INVALID_NUMBER;
+}
+
+PageId PageDirectory::nextUsed(const PageId after,
+                               const PageId num_pages) const {
+  PageId page_number = after + 1;
+  while (page_number < num_pages) {
+    std::size_t word = page_number / 64;
+    std::uint64_t used_bits = bits_[word] & (~std::uint64_t(0)
+                                             << (page_number % 64));
+    while (used_bits == 0) {
+      if (++word * 64 >= num_pages) {
+        return Page::INVALID_NUMBER;
+      }
+      used_bits = bits_[word];
+    }
+    page_number = static_cast<PageId>(word * 64 + __builtin_ctzll(used_bits));
+    if (page_number >= num_pages) {
+      break;
+    }
+    if (!isDirectoryPage(page_number)) {
+      return page_number;
+    }
+    ++page_number;
+  }
+  return Page::INVALID_NUMBER;
+}
+
+bool PageDirectory::isDirectoryPage(const PageId page_number) const {
+  return std::binary_search(pages_.begin(), pages_.end(), page_number);
+}
+
+}  // namespace badgerdb
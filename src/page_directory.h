@@ -0,0 +1,228 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Allocation bitmap of a file: one bit per page, set for pages in use.
+ *
+ * The bits for the first HEADER_BITS pages are kept in the header block of the
+ * file, after the FileHeader; each further DIRECTORY_PAGE_BITS pages get a
+ * directory page, a page of the file holding nothing but their bits.  Directory
+ * pages are taken at the end of the file when it grows past the bits it has.
+ * They form a chain: the header block holds the number of directory pages and
+ * the first one, and each directory page starts with the number of the next,
+ * so a file can have as many as its page numbers allow.  Their own bits are
+ * set so that they are never handed out, but they do not count as used pages.
+ *
+ * Bits are stored as 64-bit words in host byte order (little-endian on every
+ * platform BadgerDB runs on).  The directory does no locking of its own.
+ */
+class PageDirectory {
+ public:
+  /**
+   * Offset of the directory's area in the header block; the FileHeader comes
+   * before it.
+   */
+  static const std::size_t HEADER_AREA_OFFSET = 64;
+
+  /**
+   * Bytes before the bits in the header area, which hold the number of
+   * directory pages and the first one, and in a directory page, which hold
+   * the next one.
+   */
+  static const std::size_t LINK_SIZE = 2 * sizeof(PageId);
+
+  /**
+   * Number of pages whose bits are kept in the header block.
+   */
+  static const PageId HEADER_BITS =
+      (Page::SIZE - HEADER_AREA_OFFSET - LINK_SIZE) * 8;
+
+  /**
+   * Number of pages whose bits each directory page holds.
+   */
+  static const PageId DIRECTORY_PAGE_BITS = (Page::SIZE - LINK_SIZE) * 8;
+
+  /**
+   * Constructs a directory with only page 0, the header, in use.
+   */
+  PageDirectory();
+
+  /**
+   * Replaces the directory with the one stored in a header block area.
+   * Directory pages must then be loaded with loadDirectoryPage(), in order:
+   * only the first is known until then.
+   *
+   * @param area  The Page::SIZE - HEADER_AREA_OFFSET bytes of the area.
+   */
+  void loadHeaderArea(const char *area);
+
+  /**
+   * Stores the bits kept in the header block, the number of directory pages
+   * and the first one.
+   *
+   * @param area  The Page::SIZE - HEADER_AREA_OFFSET bytes of the area.
+   */
+  void storeHeaderArea(char *area) const;
+
+  /**
+   * Replaces the bits held by a directory page, and learns the number of the
+   * next one from it.
+   *
+   * @param index   Position of the page in directoryPages().
+   * @param page    The Page::SIZE bytes of the page.
+   */
+  void loadDirectoryPage(const std::size_t index, const char *page);
+
+  /**
+   * Stores the bits held by a directory page, after the number of the next
+   * one.
+   *
+   * @param index   Position of the page in directoryPages().
+   * @param page    The Page::SIZE bytes of the page.
+   */
+  void storeDirectoryPage(const std::size_t index, char *page) const;
+
+  /**
+   * Returns the numbers of the directory pages, in ascending order.
+   */
+  const std::vector<PageId> &directoryPages() const { return pages_; }
+
+  /**
+   * Returns the positions in directoryPages() of the directory pages changed
+   * since they were last taken, and marks them clean.
+   */
+  std::vector<std::size_t> takeDirtyPages();
+
+  /**
+   * Marks a directory page as changed, e.g. after writing it failed.
+   *
+   * @param index   Position of the page in directoryPages().
+   */
+  void markDirty(const std::size_t index) { dirty_[index] = true; }
+
+  /**
+   * Returns the number of pages the directory has bits for, which may exceed
+   * the number of pages a file can have.
+   */
+  std::uint64_t capacity() const {
+    return HEADER_BITS +
+           static_cast<std::uint64_t>(pages_.size()) * DIRECTORY_PAGE_BITS;
+  }
+
+  /**
+   * Takes a page as a directory page, extending capacity() and chaining it
+   * after the last one.  Its bit is set unless it lies past the new
+   * capacity(), in which case setUsed() must set it once further directory
+   * pages cover it.
+   *
+   * @param page_number   Number of the page, above the other directory pages:
+   *                      capacity() for the file to grow one page at a time.
+   */
+  void addDirectoryPage(const PageId page_number);
+
+  /**
+   * Returns whether a page is in use.  Page 0 and directory pages are not.
+   *
+   * @param page_number   Number of the page, below capacity().
+   */
+  bool isUsed(const PageId page_number) const {
+    return testBit(page_number) && page_number != Page::INVALID_NUMBER &&
+           !isDirectoryPage(page_number);
+  }
+
+  /**
+   * Marks a page as used or free.
+   *
+   * @param page_number   Number of the page, below capacity().
+   * @param used          Whether the page is in use.
+   */
+  void setUsed(const PageId page_number, const bool used);
+
+  /**
+   * Returns the lowest free page below num_pages, or Page::INVALID_NUMBER if
+   * every page is taken.  The search starts at the lowest page that may be
+   * free, which only moves back when a page below it is freed, so repeated
+   * searches are O(1) amortized.
+   *
+   * @param num_pages   Number of pages in the file.
+   */
+  PageId findFree(const PageId num_pages);
+
+  /**
+   * Returns the first of the lowest count consecutive free pages below
+   * num_pages, or Page::INVALID_NUMBER if there are no such pages.
+   *
+   * @param count       Number of pages wanted.
+   * @param num_pages   Number of pages in the file.
+   */
+  PageId findFreeRun(const PageId count, const PageId num_pages) const;
+
+  /**
+   * Returns the lowest used page above after, or Page::INVALID_NUMBER if there
+   * is none below num_pages.
+   *
+   * @param after       Page to search after; Page::INVALID_NUMBER to find the
+   *                    first used page.
+   * @param num_pages   Number of pages in the file.
+   */
+  PageId nextUsed(const PageId after, const PageId num_pages) const;
+
+ private:
+  /**
+   * Number of words of bits kept in the header block.
+   */
+  static const std::size_t HEADER_WORDS = HEADER_BITS / 64;
+
+  /**
+   * Number of words of bits each directory page holds.
+   */
+  static const std::size_t DIRECTORY_PAGE_WORDS = DIRECTORY_PAGE_BITS / 64;
+
+  bool testBit(const PageId page_number) const {
+    return (bits_[page_number / 64] >> (page_number % 64)) & 1;
+  }
+
+  bool isDirectoryPage(const PageId page_number) const;
+
+  /**
+   * The bits of all capacity() pages.
+   */
+  std::vector<std::uint64_t> bits_;
+
+  /**
+   * Numbers of the directory pages, in ascending order.
+   */
+  std::vector<PageId> pages_;
+
+  /**
+   * Whether each directory page has changed since it was last taken.
+   */
+  std::vector<bool> dirty_;
+
+  /**
+   * No page below this one is free.
+   */
+  PageId free_hint_;
+};
+
+static_assert(PageDirectory::HEADER_BITS % 64 == 0 &&
+                  PageDirectory::DIRECTORY_PAGE_BITS % 64 == 0,
+              "Directory bits must fill whole words.");
+
+}  // namespace badgerdb
@@ -12,6 +12,7 @@
 
 #include "file.h"
 #include "page.h"
+#include "record_view.h"
 #include "types.h"
 
 namespace badgerdb {
@@ -99,6 +100,19 @@ class PageIterator {
     return page_->getRecord(current_record_);
   }
 
+  /**
+   * Returns the current record in place, without copying it, for scans.
+   * The view is invalidated by any change to the page.
+   *
+   * @return  View of the record in page.
+   */
+  inline RecordView view() const { return page_->viewRecord(current_record_); }
+
+  /**
+   * Returns the ID of the current record.
+   */
+  inline const RecordId &record_id() const { return current_record_; }
+
   /**
    * Returns the next used slot in the page after the given slot or
    * Page::INVALID_SLOT if no slots are used after the given slot.
@@ -0,0 +1,40 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "page_view.h"
+
+#include "exceptions/invalid_record_exception.h"
+
+namespace badgerdb {
+
+std::string PageView::getRecord(const RecordId &record_id) const {
+  return viewRecord(record_id).str();
+}
+
+RecordView PageView::viewRecord(const RecordId &record_id) const {
+  if (record_id.page_number != page_number() ||
+      record_id.slot_number == Page::INVALID_SLOT ||
+      record_id.slot_number > header().num_slots) {
+    throw InvalidRecordException(record_id, page_number());
+  }
+  const PageSlot *slot = getSlot(record_id.slot_number);
+  if (!slot->used) {
+    throw InvalidRecordException(record_id, page_number());
+  }
+  return RecordView(page_ + sizeof(PageHeader) + slot->item_offset,
+                    slot->item_length);
+}
+
+SlotId PageView::nextUsedSlot(const SlotId start) const {
+  for (SlotId i = start + 1; i <= header().num_slots; ++i) {
+    if (getSlot(i)->used) return i;
+  }
+  return Page::INVALID_SLOT;
+}
+
+}  // namespace badgerdb
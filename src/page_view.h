@@ -0,0 +1,129 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "page.h"
+#include "record_view.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Read-only view of a page of a file, in place.
+ *
+ * Obtained from File::viewPage().  With FileBackend::MMAP the view points into
+ * the mapping of the file, so reading a page copies nothing but the records
+ * asked for; other backends read the page into a buffer owned by the view.
+ * A view stays valid after the File object is gone.  It shows the page as it
+ * is on disk, including later writes to it, which may be seen half done, so
+ * views are meant for pages that are not being written.
+ */
+class PageView {
+ public:
+  /**
+   * Constructs an empty view.
+   */
+  PageView()
+      : page_(nullptr),
+        page_number_(Page::INVALID_NUMBER),
+        next_page_number_(Page::INVALID_NUMBER) {}
+
+  /**
+   * Returns the number of the page.
+   */
+  PageId page_number() const { return page_number_; }
+
+  /**
+   * Returns the number of the next used page in the file.
+   */
+  PageId next_page_number() const { return next_page_number_; }
+
+  /**
+   * Returns a copy of the record with the given ID.
+   *
+   * @param record_id   ID of the record to return.
+   * @return  The record.
+   * @throws  InvalidRecordException  If the record ID is not valid for this
+   *                                  page.
+   */
+  std::string getRecord(const RecordId &record_id) const;
+
+  /**
+   * Returns the record with the given ID in place, valid as long as this
+   * view is.
+   *
+   * @param record_id   ID of the record to return.
+   * @return  View of the record.
+   * @throws  InvalidRecordException  If the record ID is not valid for this
+   *                                  page.
+   */
+  RecordView viewRecord(const RecordId &record_id) const;
+
+  /**
+   * Returns the first slot after start that holds a record, or
+   * Page::INVALID_SLOT if there is none.  Iterate over the records of the
+   * page by starting with Page::INVALID_SLOT.
+   *
+   * @param start   Slot to search after.
+   */
+  SlotId nextUsedSlot(const SlotId start) const;
+
+  /**
+   * Returns whether this view refers to a page.
+   */
+  explicit operator bool() const { return page_ != nullptr; }
+
+ private:
+  friend class File;
+
+  /**
+   * Constructs a view of Page::SIZE bytes at page, kept readable by owner.
+   */
+  PageView(std::shared_ptr<const void> owner, const char *page,
+           const PageId page_number, const PageId next_page_number)
+      : owner_(std::move(owner)),
+        page_(page),
+        page_number_(page_number),
+        next_page_number_(next_page_number) {}
+
+  const PageHeader &header() const {
+    return *reinterpret_cast<const PageHeader *>(page_);
+  }
+
+  const PageSlot *getSlot(const SlotId slot_number) const {
+    return reinterpret_cast<const PageSlot *>(
+        page_ + sizeof(PageHeader) + (slot_number - 1) * sizeof(PageSlot));
+  }
+
+  /**
+   * Keeps the bytes of the page readable.
+   */
+  std::shared_ptr<const void> owner_;
+
+  /**
+   * The page, laid out as on disk.
+   */
+  const char *page_;
+
+  /**
+   * Number of the page, from the directory of the file.
+   */
+  PageId page_number_;
+
+  /**
+   * Number of the next used page, from the directory of the file.
+   */
+  PageId next_page_number_;
+};
+
+}  // namespace badgerdb
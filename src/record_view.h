@@ -0,0 +1,94 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace badgerdb {
+
+/**
+ * @brief Read-only view of the bytes of a record, in place in its page.
+ *
+ * Returned by Page::viewRecord(), PageView::viewRecord() and
+ * PageIterator::view() instead of a copy of the record.  A view points into
+ * the page, so it is valid only while the page stays where it is and is not
+ * changed: for a page in the buffer pool, while it is pinned and no record
+ * on it is inserted, updated or deleted.  Call str() to keep a copy.
+ */
+class RecordView {
+ public:
+  /**
+   * Constructs an empty view.
+   */
+  RecordView() : data_(nullptr), size_(0) {}
+
+  /**
+   * Constructs a view of size bytes at data.
+   */
+  RecordView(const char *data, const std::size_t size)
+      : data_(data), size_(size) {}
+
+  /**
+   * Returns the first byte of the record.  The bytes are not followed by a
+   * terminating null character.
+   */
+  const char *data() const { return data_; }
+
+  /**
+   * Returns the length of the record in bytes.
+   */
+  std::size_t size() const { return size_; }
+
+  /**
+   * Returns whether the record has no bytes.
+   */
+  bool empty() const { return size_ == 0; }
+
+  const char *begin() const { return data_; }
+
+  const char *end() const { return data_ + size_; }
+
+  char operator[](const std::size_t index) const { return data_[index]; }
+
+  /**
+   * Returns a copy of the record.
+   */
+  std::string str() const { return std::string(data_, size_); }
+
+  /**
+   * Returns true if the record has the same bytes as the given one.
+   */
+  bool operator==(const RecordView &rhs) const {
+    return size_ == rhs.size_ &&
+           (size_ == 0 || std::memcmp(data_, rhs.data_, size_) == 0);
+  }
+
+  bool operator!=(const RecordView &rhs) const { return !(*this == rhs); }
+
+  bool operator==(const std::string &rhs) const {
+    return *this == RecordView(rhs.data(), rhs.size());
+  }
+
+  bool operator!=(const std::string &rhs) const { return !(*this == rhs); }
+
+ private:
+  /**
+   * First byte of the record.
+   */
+  const char *data_;
+
+  /**
+   * Length of the record in bytes.
+   */
+  std::size_t size_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,165 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "replacement_policy.h"
+
+#include <chrono>
+
+#include "arc_policy.h"
+#include "clock_policy.h"
+#include "lru_k_policy.h"
+#include "two_q_policy.h"
+
+namespace badgerdb {
+
+std::unique_ptr<ReplacementPolicy> ReplacementPolicy::create(
+    ReplacementPolicyType type, std::uint32_t numFrames) {
+  switch (type) {
+    case ReplacementPolicyType::LRU_K:
+      return std::unique_ptr<ReplacementPolicy>(new LruKPolicy(numFrames));
+    case ReplacementPolicyType::TWO_Q:
+      return std::unique_ptr<ReplacementPolicy>(new TwoQPolicy(numFrames));
+    case ReplacementPolicyType::ARC:
+      return std::unique_ptr<ReplacementPolicy>(new ArcPolicy(numFrames));
+    case ReplacementPolicyType::CLOCK:
+    default:
+      return std::unique_ptr<ReplacementPolicy>(new ClockPolicy(numFrames));
+  }
+}
+
+ReplacementPolicy::ReplacementPolicy(std::uint32_t numFrames)
+    : numFrames(numFrames) {}
+
+void ReplacementPolicy::frameAccessed(FrameId frame) {
+  localStats().hits++;
+  onAccess(frame);
+}
+
+void ReplacementPolicy::frameLoaded(FrameId frame, FileId fileId,
+                                    PageId pageNo) {
+  localStats().misses++;
+  onLoad(frame, makePageKey(fileId, pageNo));
+}
+
+bool ReplacementPolicy::pickVictim(const ClaimFn &tryClaim, FrameId &frame) {
+  const auto start = std::chrono::steady_clock::now();
+  std::uint64_t examined = 0;
+  const bool found = chooseVictim(tryClaim, frame, examined);
+  StatsStripe &stripe = localStats();
+  stripe.victimsExamined += examined;
+  stripe.evictionNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+  if (found) stripe.evictions++;
+  return found;
+}
+
+FrameId ReplacementPolicy::claimFromList(FrameLists &lists, int list,
+                                         const ClaimFn &tryClaim,
+                                         std::uint64_t &examined) {
+  for (FrameId frame = lists.front(list); frame != FrameLists::NO_FRAME;
+       frame = lists.next(frame)) {
+    ++examined;
+    if (tryClaim(frame)) {
+      lists.remove(frame);
+      return frame;
+    }
+  }
+  return FrameLists::NO_FRAME;
+}
+
+void ReplacementPolicy::peekList(const FrameLists &lists, int list,
+                                 std::vector<FrameId> &frames,
+                                 std::uint32_t count) {
+  for (FrameId frame = lists.front(list);
+       frame != FrameLists::NO_FRAME && frames.size() < count;
+       frame = lists.next(frame)) {
+    frames.push_back(frame);
+  }
+}
+
+ReplacementStats ReplacementPolicy::getStats() const {
+  ReplacementStats total;
+  for (const StatsStripe &stripe : stats) {
+    total.hits += stripe.hits;
+    total.misses += stripe.misses;
+    total.evictions += stripe.evictions;
+    total.victimsExamined += stripe.victimsExamined;
+    total.evictionNanos += stripe.evictionNanos;
+  }
+  return total;
+}
+
+void ReplacementPolicy::clearStats() {
+  for (StatsStripe &stripe : stats) stripe.clear();
+}
+
+ReplacementPolicy::StatsStripe &ReplacementPolicy::localStats() {
+  static std::atomic<unsigned> nextStripe(0);
+  thread_local const unsigned stripe = nextStripe++ % NUM_STAT_STRIPES;
+  return stats[stripe];
+}
+
+const int FrameLists::NO_LIST;
+const FrameId FrameLists::NO_FRAME;
+
+FrameLists::FrameLists(std::uint32_t numFrames, int numLists)
+    : prevs(numFrames, NO_FRAME),
+      nexts(numFrames, NO_FRAME),
+      lists(numFrames, NO_LIST),
+      heads(numLists, NO_FRAME),
+      tails(numLists, NO_FRAME),
+      sizes(numLists, 0) {}
+
+void FrameLists::pushBack(int list, FrameId frame) {
+  prevs[frame] = tails[list];
+  nexts[frame] = NO_FRAME;
+  if (tails[list] == NO_FRAME)
+    heads[list] = frame;
+  else
+    nexts[tails[list]] = frame;
+  tails[list] = frame;
+  lists[frame] = list;
+  ++sizes[list];
+}
+
+void FrameLists::remove(FrameId frame) {
+  const int list = lists[frame];
+  if (list == NO_LIST) return;
+  if (prevs[frame] == NO_FRAME)
+    heads[list] = nexts[frame];
+  else
+    nexts[prevs[frame]] = nexts[frame];
+  if (nexts[frame] == NO_FRAME)
+    tails[list] = prevs[frame];
+  else
+    prevs[nexts[frame]] = prevs[frame];
+  prevs[frame] = nexts[frame] = NO_FRAME;
+  lists[frame] = NO_LIST;
+  --sizes[list];
+}
+
+bool GhostList::remove(std::uint64_t pageKey) {
+  auto entry = index.find(pageKey);
+  if (entry == index.end()) return false;
+  keys.erase(entry->second);
+  index.erase(entry);
+  return true;
+}
+
+void GhostList::pushBack(std::uint64_t pageKey) {
+  keys.push_back(pageKey);
+  index[pageKey] = std::prev(keys.end());
+}
+
+void GhostList::popFront() {
+  index.erase(keys.front());
+  keys.pop_front();
+}
+
+}  // namespace badgerdb
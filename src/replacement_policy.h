@@ -0,0 +1,389 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Page replacement policies BufMgr can be constructed with.
+ */
+enum class ReplacementPolicyType {
+  /**
+   * Second-chance clock.
+   */
+  CLOCK,
+
+  /**
+   * LRU-K with K = 2 (evicts the page with the oldest second-to-last access).
+   */
+  LRU_K,
+
+  /**
+   * 2Q (Johnson and Shasha), with A1in at 25% and A1out at 50% of the pool.
+   */
+  TWO_Q,
+
+  /**
+   * Adaptive Replacement Cache (Megiddo and Modha).
+   */
+  ARC,
+};
+
+/**
+ * @brief Counters a replacement policy keeps about its own behaviour.
+ */
+struct ReplacementStats {
+  /**
+   * Accesses to pages already in the buffer pool.
+   */
+  std::uint64_t hits;
+
+  /**
+   * Pages brought into the buffer pool (reads and allocations).
+   */
+  std::uint64_t misses;
+
+  /**
+   * Frames handed out by the policy for reuse.
+   */
+  std::uint64_t evictions;
+
+  /**
+   * Frames the policy looked at while choosing those victims.
+   */
+  std::uint64_t victimsExamined;
+
+  /**
+   * Time spent choosing those victims, in nanoseconds.
+   */
+  std::uint64_t evictionNanos;
+
+  /**
+   * Returns hits / (hits + misses), or 0 if there were no accesses.
+   */
+  double hitRatio() const {
+    return hits + misses == 0 ? 0.0 : double(hits) / double(hits + misses);
+  }
+
+  /**
+   * Returns the average number of frames examined per eviction.
+   */
+  double examinedPerEviction() const {
+    return evictions == 0 ? 0.0 : double(victimsExamined) / double(evictions);
+  }
+
+  /**
+   * Returns the average time spent choosing a victim, in nanoseconds.
+   */
+  double nanosPerEviction() const {
+    return evictions == 0 ? 0.0 : double(evictionNanos) / double(evictions);
+  }
+
+  /**
+   * Clear all values
+   */
+  void clear() { hits = misses = evictions = victimsExamined = evictionNanos = 0; }
+
+  ReplacementStats() { clear(); }
+};
+
+/**
+ * @brief Doubly linked lists of frames threaded through per-frame arrays.
+ *
+ * A frame is on at most one list at a time.  Lists are identified by small
+ * integers; the back of a list is its most recently inserted end.
+ */
+class FrameLists {
+ public:
+  /**
+   * List number of frames that are on no list.
+   */
+  static const int NO_LIST = -1;
+
+  FrameLists(std::uint32_t numFrames, int numLists);
+
+  /**
+   * Appends frame (which must be on no list) to the back of list.
+   */
+  void pushBack(int list, FrameId frame);
+
+  /**
+   * Unlinks frame from its list, if any.
+   */
+  void remove(FrameId frame);
+
+  /**
+   * Returns the front (oldest) frame of list, or NO_FRAME if it is empty.
+   */
+  FrameId front(int list) const { return heads[list]; }
+
+  /**
+   * Returns the frame after frame on its list, or NO_FRAME at the back.
+   */
+  FrameId next(FrameId frame) const { return nexts[frame]; }
+
+  /**
+   * Returns the list frame is on, or NO_LIST.
+   */
+  int listOf(FrameId frame) const { return lists[frame]; }
+
+  /**
+   * Returns the number of frames on list.
+   */
+  std::uint32_t size(int list) const { return sizes[list]; }
+
+  /**
+   * Frame number meaning "no frame".
+   */
+  static const FrameId NO_FRAME = ~FrameId(0);
+
+ private:
+  std::vector<FrameId> prevs;
+  std::vector<FrameId> nexts;
+  std::vector<int> lists;
+  std::vector<FrameId> heads;
+  std::vector<FrameId> tails;
+  std::vector<std::uint32_t> sizes;
+};
+
+/**
+ * @brief FIFO of keys of pages that are no longer in the pool ("ghosts"), with
+ * constant-time membership tests and removal.
+ */
+class GhostList {
+ public:
+  bool contains(std::uint64_t pageKey) const {
+    return index.find(pageKey) != index.end();
+  }
+
+  /**
+   * Removes pageKey if present; returns whether it was.
+   */
+  bool remove(std::uint64_t pageKey);
+
+  /**
+   * Appends pageKey (which must not be present) at the back.
+   */
+  void pushBack(std::uint64_t pageKey);
+
+  /**
+   * Returns the oldest key.  The list must not be empty.
+   */
+  std::uint64_t front() const { return keys.front(); }
+
+  /**
+   * Drops the oldest key.  The list must not be empty.
+   */
+  void popFront();
+
+  std::size_t size() const { return keys.size(); }
+
+ private:
+  std::list<std::uint64_t> keys;
+  std::unordered_map<std::uint64_t, std::list<std::uint64_t>::iterator> index;
+};
+
+/**
+ * Packs a (file, page) pair into the key used by ghost lists.
+ */
+inline std::uint64_t makePageKey(FileId fileId, PageId pageNo) {
+  return (static_cast<std::uint64_t>(fileId) << 32) | pageNo;
+}
+
+/**
+ * @brief Interface through which BufMgr asks which frame to reuse.
+ *
+ * BufMgr reports every hit, every page brought into a frame and every frame it
+ * empties, and asks for a victim when it needs a frame.  A chosen victim is
+ * taken out of the policy's bookkeeping until BufMgr either reloads it
+ * (frameLoaded(), which is when the eviction of the old page counts), gives it
+ * back unchanged (frameRestored(), e.g. because it was pinned again while its
+ * page was being written back) or empties it (frameFreed()).
+ *
+ * All methods may be called concurrently.  Clock is latch-free; the other
+ * policies serialize on a policy latch.  tryClaim callbacks are invoked with
+ * that latch held and must not block.
+ */
+class ReplacementPolicy {
+ public:
+  /**
+   * Callback that tries to claim a frame for eviction: returns true (with the
+   * frame latched and unpinned) or false if the frame cannot be evicted now.
+   */
+  typedef std::function<bool(FrameId)> ClaimFn;
+
+  /**
+   * Creates a policy of the given type for a pool of numFrames frames.
+   *
+   * @param type      Policy to create.
+   * @param numFrames Number of frames in the buffer pool.
+   * @return  The policy.
+   */
+  static std::unique_ptr<ReplacementPolicy> create(ReplacementPolicyType type,
+                                                   std::uint32_t numFrames);
+
+  virtual ~ReplacementPolicy() {}
+
+  /**
+   * Returns a short name for the policy.
+   */
+  virtual const char *name() const = 0;
+
+  /**
+   * Records a hit on the page in the given frame.
+   *
+   * @param frame Frame that was accessed.
+   */
+  void frameAccessed(FrameId frame);
+
+  /**
+   * Records that a page was brought into the given frame.  The frame is
+   * normally a victim returned by pickVictim() or a free frame, but may also
+   * still hold a page the policy considers resident, when a
+   * BufAccessStrategy recycles one of its ring frames; that page is then
+   * forgotten without leaving any history behind.
+   *
+   * @param frame   Frame that now holds the page.
+   * @param fileId  Id of the page's file.
+   * @param pageNo  Number of the page.
+   */
+  void frameLoaded(FrameId frame, FileId fileId, PageId pageNo);
+
+  /**
+   * Records that the given frame no longer holds a page.
+   *
+   * @param frame Frame that was emptied.
+   */
+  virtual void frameFreed(FrameId frame) = 0;
+
+  /**
+   * Gives a victim back unchanged; it keeps the page it held.
+   *
+   * @param frame Victim returned by pickVictim().
+   */
+  virtual void frameRestored(FrameId frame) = 0;
+
+  /**
+   * Lists frames holding pages, in the order the policy would currently
+   * consider them for eviction, without changing any state.  Used by the
+   * background writer to clean pages before they are evicted.
+   *
+   * @param frames  Frames are appended to this vector.
+   * @param count   Maximum number of frames to list.
+   */
+  virtual void peekVictims(std::vector<FrameId> &frames,
+                           std::uint32_t count) = 0;
+
+  /**
+   * Chooses a frame to reuse.
+   *
+   * @param tryClaim  Callback claiming a candidate frame.
+   * @param frame     Set to the claimed frame.
+   * @return  False if no frame could be claimed.
+   */
+  bool pickVictim(const ClaimFn &tryClaim, FrameId &frame);
+
+  /**
+   * Returns a snapshot of the policy's counters.
+   */
+  ReplacementStats getStats() const;
+
+  /**
+   * Clears the policy's counters.
+   */
+  void clearStats();
+
+ protected:
+  explicit ReplacementPolicy(std::uint32_t numFrames);
+
+  /**
+   * Policy-specific part of frameAccessed().
+   */
+  virtual void onAccess(FrameId frame) = 0;
+
+  /**
+   * Policy-specific part of frameLoaded().
+   */
+  virtual void onLoad(FrameId frame, std::uint64_t pageKey) = 0;
+
+  /**
+   * Policy-specific part of pickVictim().
+   *
+   * @param tryClaim  Callback claiming a candidate frame.
+   * @param frame     Set to the claimed frame.
+   * @param examined  Incremented for every candidate looked at.
+   * @return  False if no frame could be claimed.
+   */
+  virtual bool chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                            std::uint64_t &examined) = 0;
+
+  /**
+   * Walks list from its front and unlinks and returns the first frame
+   * tryClaim accepts.
+   *
+   * @param lists     Lists of the policy.
+   * @param list      List to walk.
+   * @param tryClaim  Callback claiming a candidate frame.
+   * @param examined  Incremented for every candidate looked at.
+   * @return  The claimed frame, or FrameLists::NO_FRAME.
+   */
+  static FrameId claimFromList(FrameLists &lists, int list,
+                               const ClaimFn &tryClaim,
+                               std::uint64_t &examined);
+
+  /**
+   * Appends frames of list, from its front, to frames until it holds count.
+   */
+  static void peekList(const FrameLists &lists, int list,
+                       std::vector<FrameId> &frames, std::uint32_t count);
+
+  /**
+   * Number of frames in the buffer pool.
+   */
+  const std::uint32_t numFrames;
+
+ private:
+  /**
+   * One stripe of the counters, aligned to a cache line (see BufStatsStripe).
+   */
+  struct alignas(64) StatsStripe {
+    std::atomic<std::uint64_t> hits;
+    std::atomic<std::uint64_t> misses;
+    std::atomic<std::uint64_t> evictions;
+    std::atomic<std::uint64_t> victimsExamined;
+    std::atomic<std::uint64_t> evictionNanos;
+
+    void clear() {
+      hits = misses = evictions = victimsExamined = evictionNanos = 0;
+    }
+
+    StatsStripe() { clear(); }
+  };
+
+  static const int NUM_STAT_STRIPES = 16;
+
+  /**
+   * Returns the counter stripe for the calling thread.
+   */
+  StatsStripe &localStats();
+
+  StatsStripe stats[NUM_STAT_STRIPES];
+};
+
+}  // namespace badgerdb
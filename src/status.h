@@ -0,0 +1,59 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+namespace badgerdb {
+
+/**
+ * @brief Outcome of the non-throwing ("try") variants of hot-path operations.
+ *
+ * Conditions that are normal control flow for callers (a buffer pool miss, a
+ * full page, a page that does not exist) are reported through a Status
+ * instead of an exception.  The throwing variants of the same operations are
+ * thin wrappers that turn a Status other than OK into the matching exception
+ * from src/exceptions/.
+ */
+enum class Status {
+  /**
+   * The operation succeeded.
+   */
+  OK,
+
+  /**
+   * The (file, page) entry is not in the buffer pool hash table.
+   * Thrown as HashNotFoundException.
+   */
+  HASH_NOT_FOUND,
+
+  /**
+   * The (file, page) entry is already in the buffer pool hash table.
+   * Thrown as HashAlreadyPresentException.
+   */
+  HASH_ALREADY_PRESENT,
+
+  /**
+   * The page does not exist in the file or is not in use.
+   * Thrown as InvalidPageException.
+   */
+  INVALID_PAGE,
+
+  /**
+   * The page does not have enough free space for the record.
+   * Thrown as InsufficientSpaceException.
+   */
+  INSUFFICIENT_SPACE,
+
+  /**
+   * Every frame of the buffer pool is pinned.
+   * Thrown as BufferExceededException.
+   */
+  BUFFER_EXCEEDED,
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,94 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "two_q_policy.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+TwoQPolicy::TwoQPolicy(std::uint32_t numFrames)
+    : ReplacementPolicy(numFrames),
+      kin(std::max<std::uint32_t>(1, numFrames / 4)),
+      kout(std::max<std::uint32_t>(1, numFrames / 2)),
+      lists(numFrames, NUM_LISTS),
+      frames(numFrames, FrameState{0, FREE}) {
+  for (FrameId frame = 0; frame < numFrames; frame++)
+    lists.pushBack(FREE, frame);
+}
+
+void TwoQPolicy::commitEviction(FrameId frame) {
+  FrameState &state = frames[frame];
+  if (lists.listOf(frame) != FrameLists::NO_LIST || state.pageKey == 0) return;
+  if (state.list == A1IN) {
+    a1out.pushBack(state.pageKey);
+    if (a1out.size() > kout) a1out.popFront();
+  }
+  state.pageKey = 0;
+}
+
+void TwoQPolicy::onAccess(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  // Hits in A1in are deliberately ignored: a burst of correlated references
+  // must not promote a page to Am.
+  if (lists.listOf(frame) != AM) return;
+  lists.remove(frame);
+  lists.pushBack(AM, frame);
+}
+
+void TwoQPolicy::onLoad(FrameId frame, std::uint64_t pageKey) {
+  std::lock_guard<std::mutex> guard(latch);
+  commitEviction(frame);
+  lists.remove(frame);
+
+  FrameState &state = frames[frame];
+  state.pageKey = pageKey;
+  state.list = a1out.remove(pageKey) ? AM : A1IN;
+  lists.pushBack(state.list, frame);
+}
+
+void TwoQPolicy::frameFreed(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  commitEviction(frame);
+  lists.remove(frame);
+  frames[frame].pageKey = 0;
+  frames[frame].list = FREE;
+  lists.pushBack(FREE, frame);
+}
+
+void TwoQPolicy::frameRestored(FrameId frame) {
+  std::lock_guard<std::mutex> guard(latch);
+  if (lists.listOf(frame) != FrameLists::NO_LIST) return;
+  lists.pushBack(frames[frame].list, frame);
+}
+
+void TwoQPolicy::peekVictims(std::vector<FrameId> &frames,
+                             std::uint32_t count) {
+  std::lock_guard<std::mutex> guard(latch);
+  const int first = lists.size(A1IN) > kin ? A1IN : AM;
+  peekList(lists, first, frames, count);
+  peekList(lists, first == A1IN ? AM : A1IN, frames, count);
+}
+
+bool TwoQPolicy::chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                              std::uint64_t &examined) {
+  std::lock_guard<std::mutex> guard(latch);
+  const int first = lists.size(A1IN) > kin ? A1IN : AM;
+  const int second = first == A1IN ? AM : A1IN;
+  FrameId victim = claimFromList(lists, FREE, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME)
+    victim = claimFromList(lists, first, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME)
+    victim = claimFromList(lists, second, tryClaim, examined);
+  if (victim == FrameLists::NO_FRAME) return false;
+
+  frame = victim;
+  return true;
+}
+
+}  // namespace badgerdb
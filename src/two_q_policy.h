@@ -0,0 +1,93 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "replacement_policy.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Full 2Q replacement.
+ *
+ * New pages enter the FIFO A1in.  Pages evicted from A1in are remembered in
+ * the ghost FIFO A1out; a page that is referenced again while remembered there
+ * is promoted into the LRU list Am.  Frames are reclaimed from A1in while it
+ * holds more than its share (Kin = 25% of the pool), otherwise from Am.
+ * A1out remembers up to Kout = 50% of the pool.
+ */
+class TwoQPolicy : public ReplacementPolicy {
+ public:
+  explicit TwoQPolicy(std::uint32_t numFrames);
+
+  const char *name() const override { return "2q"; }
+
+  void frameFreed(FrameId frame) override;
+
+  void frameRestored(FrameId frame) override;
+
+  void peekVictims(std::vector<FrameId> &frames, std::uint32_t count) override;
+
+ protected:
+  void onAccess(FrameId frame) override;
+
+  void onLoad(FrameId frame, std::uint64_t pageKey) override;
+
+  bool chooseVictim(const ClaimFn &tryClaim, FrameId &frame,
+                    std::uint64_t &examined) override;
+
+ private:
+  enum { FREE, A1IN, AM, NUM_LISTS };
+
+  /**
+   * @brief Bookkeeping for one frame.
+   */
+  struct FrameState {
+    /**
+     * Key of the page in the frame (also while it is a victim), or 0.
+     */
+    std::uint64_t pageKey;
+
+    /**
+     * List the frame is on, or was taken from while it is a victim.
+     */
+    int list;
+  };
+
+  /**
+   * If frame was handed out as a victim from A1in, remembers its page in
+   * A1out.
+   */
+  void commitEviction(FrameId frame);
+
+  /**
+   * Maximum size of A1in before it is preferred for eviction.
+   */
+  const std::uint32_t kin;
+
+  /**
+   * Maximum size of A1out.
+   */
+  const std::uint32_t kout;
+
+  /**
+   * Latch guarding everything below.
+   */
+  std::mutex latch;
+
+  FrameLists lists;
+
+  std::vector<FrameState> frames;
+
+  GhostList a1out;
+};
+
+}  // namespace badgerdb
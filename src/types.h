@@ -12,6 +12,11 @@
 
 namespace badgerdb {
 
+/**
+ * @brief Identifier for an open file, assigned by File (see File::id()).
+ */
+typedef std::uint32_t FileId;
+
 /**
  * @brief Identifier for a page in a file.
  */